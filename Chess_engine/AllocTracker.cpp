@@ -0,0 +1,285 @@
+#include "AllocTracker.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstdio>
+#include <atomic>
+#include <new>
+#include <vector>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+//##################################################################################################################
+//                                                     VARIABLES
+//##################################################################################################################
+
+// hot region names (same order as the hot region enum)
+const char* hot_region_names[hot_region_count] = { "movegen", "make/unmake", "search" };
+
+#ifdef HOT_PATH_ALLOC_CHECK
+
+// innermost hot region of the thread, -1 outside of any region
+thread_local int current_hot_region = -1;
+
+// allocations per hot region, only touched when a hot region allocates
+std::atomic<uint64_t> hot_region_allocations[hot_region_count];
+
+// charge an allocation to the current hot region
+static inline void countAllocation() {
+	if (current_hot_region >= 0)
+		hot_region_allocations[current_hot_region].fetch_add(1, std::memory_order_relaxed);
+}
+
+//##################################################################################################################
+//                                                     ALLOCATION HOOKS
+//##################################################################################################################
+
+#if defined(__GLIBC__)
+
+// glibc: interpose the malloc family, operator new ends up here as well (the over-aligned one in aligned_alloc
+// or posix_memalign)
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size) noexcept {
+	countAllocation();
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+	countAllocation();
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+	countAllocation();
+	return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+	countAllocation();
+	return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+	countAllocation();
+	return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) noexcept {
+	// a power of two multiple of sizeof(void*)
+	if (alignment % sizeof(void*) || (alignment & (alignment - 1)))
+		return EINVAL;
+	countAllocation();
+	void* memory = __libc_memalign(alignment, size);
+	if (!memory)
+		return ENOMEM;
+	*ptr = memory;
+	return 0;
+}
+
+void free(void* ptr) noexcept {
+	__libc_free(ptr);
+}
+
+}
+
+#else
+
+// other runtimes: replace the global operator new/delete
+void* operator new(std::size_t size) {
+	countAllocation();
+	if (void* ptr = std::malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	countAllocation();
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+// over-aligned types
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	countAllocation();
+	std::size_t align = (std::size_t)alignment;
+#ifdef _WIN32
+	if (void* ptr = _aligned_malloc(size ? size : 1, align))
+#else
+	if (void* ptr = std::aligned_alloc(align, ((size ? size : 1) + align - 1) / align * align))
+#endif
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	try {
+		return operator new(size, alignment);
+	}
+	catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return operator new(size, alignment, std::nothrow);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+#ifdef _WIN32
+	_aligned_free(ptr);
+#else
+	std::free(ptr);
+#endif
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept {
+	operator delete(ptr, alignment);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+	operator delete(ptr, alignment);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+	operator delete(ptr, alignment);
+}
+
+#endif
+
+//##################################################################################################################
+//                                                     HOT REGION METHODS
+//##################################################################################################################
+
+HotRegion::HotRegion(int region) {
+	m_previous = current_hot_region;
+	current_hot_region = region;
+}
+
+HotRegion::~HotRegion() {
+	current_hot_region = m_previous;
+}
+
+#endif
+
+//##################################################################################################################
+//                                                     FUNCTIONS
+//##################################################################################################################
+
+bool hotPathAllocCheckEnabled() {
+#ifdef HOT_PATH_ALLOC_CHECK
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint64_t hotRegionAllocations(int region) {
+#ifdef HOT_PATH_ALLOC_CHECK
+	return hot_region_allocations[region].load(std::memory_order_relaxed);
+#else
+	(void)region;
+	return 0;
+#endif
+}
+
+uint64_t hotRegionAllocations() {
+	uint64_t total = 0;
+	for (int region = 0; region < hot_region_count; ++region)
+		total += hotRegionAllocations(region);
+	return total;
+}
+
+void resetHotRegionAllocations() {
+#ifdef HOT_PATH_ALLOC_CHECK
+	for (int region = 0; region < hot_region_count; ++region)
+		hot_region_allocations[region].store(0, std::memory_order_relaxed);
+#endif
+}
+
+bool checkHotRegions(const char* label) {
+	if (!hotPathAllocCheckEnabled())
+		return true;
+
+	printf("    Hot region allocations (%s):", label);
+	for (int region = 0; region < hot_region_count; ++region)
+		printf(" %s %llu ", hot_region_names[region], (unsigned long long)hotRegionAllocations(region));
+	printf("\n");
+
+	if (hotRegionAllocations()) {
+		printf("    FAILED: heap allocations inside hot regions\n\n");
+		return false;
+	}
+	return true;
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+void allocTrackerTest() {
+	printf("\n     Hot region allocation check\n\n");
+	if (!hotPathAllocCheckEnabled()) {
+		printf("  compiled out (define HOT_PATH_ALLOC_CHECK)\n\n");
+		return;
+	}
+
+	// over-aligned type, operator new(size_t, align_val_t)
+	struct alignas(64) aligned { char bytes[64]; };
+
+	std::vector<int> plain;
+	std::vector<aligned> over_aligned;
+	resetHotRegionAllocations();
+	{
+		HotRegion hot_region(hot_make_unmake);
+		plain.emplace_back();
+	}
+	uint64_t plain_count = hotRegionAllocations(hot_make_unmake);
+	{
+		HotRegion hot_region(hot_make_unmake);
+		over_aligned.emplace_back();
+	}
+	uint64_t aligned_count = hotRegionAllocations(hot_make_unmake) - plain_count;
+
+	// outside of any region nothing is counted
+	over_aligned.reserve(1024);
+	bool outside = hotRegionAllocations() == plain_count + aligned_count;
+	resetHotRegionAllocations();
+
+	printf("  std::vector<int>             %llu allocation(s) %s\n", (unsigned long long)plain_count, plain_count ? "counted" : "MISSED");
+	printf("  std::vector<alignas(64)>     %llu allocation(s) %s\n", (unsigned long long)aligned_count, aligned_count ? "counted" : "MISSED");
+	printf("  outside of a region          %s\n\n", outside ? "not counted" : "COUNTED");
+}
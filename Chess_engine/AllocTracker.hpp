@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+
+// Debug builds count heap allocations made inside hot regions,
+// define HOT_PATH_ALLOC_CHECK to enable it in any other build.
+#if defined(_DEBUG) && !defined(HOT_PATH_ALLOC_CHECK)
+#define HOT_PATH_ALLOC_CHECK
+#endif
+
+// hot regions
+enum { hot_movegen, hot_make_unmake, hot_search, hot_region_count };
+
+#ifdef HOT_PATH_ALLOC_CHECK
+
+// scoped hot region, allocations are charged to the innermost region of the calling thread
+class HotRegion {
+	int m_previous;
+public:
+	explicit HotRegion(int region);
+	~HotRegion();
+	HotRegion(const HotRegion&) = delete;
+	HotRegion& operator=(const HotRegion&) = delete;
+};
+
+#else
+
+// no-op when the check is compiled out
+class HotRegion {
+public:
+	explicit HotRegion(int) {}
+};
+
+#endif
+
+// true when the allocation check is compiled in
+bool hotPathAllocCheckEnabled();
+
+// allocations made inside a hot region since the last reset (all threads)
+uint64_t hotRegionAllocations(int region);
+
+uint64_t hotRegionAllocations();
+
+void resetHotRegionAllocations();
+
+// print allocations per region, returns false if any hot region allocated
+bool checkHotRegions(const char* label);
+
+// allocations of plain & over-aligned types inside a hot region are counted
+void allocTrackerTest();
@@ -0,0 +1,159 @@
+#include "AttackMaps.hpp"
+#include "Bench.hpp"
+#include "Utility.hpp"
+#include <cstdio>
+#include <cstring>
+
+//##################################################################################################################
+//                                                     VARIABLES
+//##################################################################################################################
+
+// mobility per reachable square & the typical number of squares [piece type]
+const int mobility_mg[6] = { 0, 4, 5, 2, 1, 0 };
+const int mobility_eg[6] = { 0, 4, 5, 4, 2, 0 };
+const int mobility_base[6] = { 0, 4, 7, 7, 14, 0 };
+
+// weight of an attacked king zone square [piece type]
+const int king_attack_weight[6] = { 0, 2, 2, 3, 5, 0 };
+
+// king danger grows with the square of the weighted attacks (midgame only)
+const int max_king_danger = 400;
+
+// pieces attacked & not defended, pieces attacked by pawns
+const int hanging_mg = -20, hanging_eg = -15;
+const int pawn_threat_mg = -25, pawn_threat_eg = -20;
+
+//##################################################################################################################
+//                                                     FUNCTIONS
+//##################################################################################################################
+
+void buildAttackMaps(const Board& board, AttackMaps& attacks)
+{
+	const Moves& moves = sharedMoves();
+	const std::array<uint64_t, 12>& bitboards = board.bitboards();
+	uint64_t occupancy = board.occupancies()[both];
+
+	std::memset(&attacks, 0, sizeof(attacks));
+
+	// pawns & kings first, the mobility area & king zones depend on them
+	for (int side = white; side <= black; side++) {
+		int pawn = (side == white) ? P : p;
+		int king = (side == white) ? K : k;
+
+		uint64_t bitboard = bitboards[pawn];
+		while (bitboard) {
+			attacks.by_piece[pawn] |= moves.getPawnAttacks(side, get_ls1b_index(bitboard));
+			bitboard &= bitboard - 1;
+		}
+
+		int king_square = get_ls1b_index(bitboards[king]);
+		attacks.by_piece[king] = moves.getKingAttacks(king_square);
+		attacks.king_zone[side] = attacks.by_piece[king] | (1ULL << king_square);
+	}
+
+	// knights, bishops, rooks & queens: one lookup each for the maps, the mobility & the king zone attacks
+	for (int side = white; side <= black; side++) {
+		uint64_t mobility_area = ~board.occupancies()[side] & ~attacks.by_piece[(side == white) ? p : P];
+		uint64_t enemy_king_zone = attacks.king_zone[side ^ 1];
+
+		for (int type = N; type <= Q; type++) {
+			int piece = (side == white) ? type : type + 6;
+			uint64_t bitboard = bitboards[piece];
+
+			while (bitboard) {
+				int square = get_ls1b_index(bitboard);
+				uint64_t piece_attacks;
+				switch (type) {
+				case N: piece_attacks = moves.getKnightAttacks(square); break;
+				case B: piece_attacks = moves.getBishopAttacks(square, occupancy); break;
+				case R: piece_attacks = moves.getRookAttacks(square, occupancy); break;
+				default: piece_attacks = moves.getQueenAttacks(square, occupancy); break;
+				}
+				attacks.by_piece[piece] |= piece_attacks;
+
+				int mobility = count_bits(piece_attacks & mobility_area) - mobility_base[type];
+				attacks.mobility_mg[side] += mobility_mg[type] * mobility;
+				attacks.mobility_eg[side] += mobility_eg[type] * mobility;
+
+				if (piece_attacks & enemy_king_zone) {
+					attacks.king_attackers[side ^ 1]++;
+					attacks.king_attack_units[side ^ 1] += king_attack_weight[type] * count_bits(piece_attacks & enemy_king_zone);
+				}
+				bitboard &= bitboard - 1;
+			}
+		}
+	}
+
+	for (int piece = P; piece <= K; piece++) {
+		attacks.by_side[white] |= attacks.by_piece[piece];
+		attacks.by_side[black] |= attacks.by_piece[piece + 6];
+	}
+
+	for (int side = white; side <= black; side++) {
+		uint64_t pieces = board.occupancies()[side] & ~bitboards[(side == white) ? K : k];
+		attacks.hanging[side] = pieces & attacks.by_side[side ^ 1] & ~attacks.by_side[side];
+	}
+}
+
+void evaluateAttacks(const Board& board, const AttackMaps& attacks, int& score_mg, int& score_eg)
+{
+	score_mg = attacks.mobility_mg[white] - attacks.mobility_mg[black];
+	score_eg = attacks.mobility_eg[white] - attacks.mobility_eg[black];
+
+	for (int side = white; side <= black; side++) {
+		int sign = (side == white) ? 1 : -1;
+
+		// a single attacker is rarely dangerous
+		if (attacks.king_attackers[side] >= 2) {
+			int units = attacks.king_attack_units[side];
+			int danger = units * units / 4;
+			score_mg -= sign * (danger < max_king_danger ? danger : max_king_danger);
+		}
+
+		int hanging = count_bits(attacks.hanging[side]);
+		score_mg += sign * hanging * hanging_mg;
+		score_eg += sign * hanging * hanging_eg;
+
+		// knights, bishops, rooks & queens attacked by pawns
+		uint64_t pieces = board.occupancies()[side] & ~board.bitboards()[(side == white) ? P : p] & ~board.bitboards()[(side == white) ? K : k];
+		int threatened = count_bits(pieces & attacks.by_piece[(side == white) ? p : P]);
+		score_mg += sign * threatened * pawn_threat_mg;
+		score_eg += sign * threatened * pawn_threat_eg;
+	}
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+void attackMapsTest()
+{
+	Board b;
+	AttackMaps attacks;
+
+	printf("\n     Attack maps\n\n");
+	for (const BenchPosition& position : benchPositions()) {
+		b.parse_fen(position.fen);
+		buildAttackMaps(b, attacks);
+
+		// every square against the attack detection of the move generator
+		int mismatches = 0;
+		for (int square = 0; square < 64; square++)
+			for (int side = white; side <= black; side++)
+				mismatches += (bool)(attacks.by_side[side] & (1ULL << square)) != b.isSquareAttacked(square, side);
+
+		const int calls = 100000;
+		uint64_t start = get_time_ns();
+		for (int i = 0; i < calls; i++)
+			buildAttackMaps(b, attacks);
+		double ns = (double)(get_time_ns() - start) / calls;
+
+		int score_mg, score_eg;
+		evaluateAttacks(b, attacks, score_mg, score_eg);
+		printf("  %-12s mismatches %d  mobility %4d/%4d  king attackers %d/%d  hanging %d/%d  mg %5d eg %5d  %6.1f ns\n",
+			position.name.c_str(), mismatches, attacks.mobility_mg[white], attacks.mobility_mg[black],
+			attacks.king_attackers[white], attacks.king_attackers[black], count_bits(attacks.hanging[white]),
+			count_bits(attacks.hanging[black]), score_mg, score_eg, ns);
+	}
+	printf("\n");
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "Board.hpp"
+
+// attack sets of a position, built once per node by the evaluation & reused by move ordering
+struct AttackMaps {
+	// squares attacked by the pieces of each kind [piece] & by each side [side] (own pieces included: defended)
+	uint64_t by_piece[12];
+	uint64_t by_side[2];
+
+	// king square & the squares next to it [side]
+	uint64_t king_zone[2];
+
+	// pieces (king excluded) attacked by the other side & not defended [side]
+	uint64_t hanging[2];
+
+	// mobility scores of knights, bishops, rooks & queens [side]
+	int mobility_mg[2];
+	int mobility_eg[2];
+
+	// pieces attacking the king zone of side & their weighted attacks [side]
+	int king_attackers[2];
+	int king_attack_units[2];
+};
+
+// all the attack sets, mobility & king zone attacks with one slider lookup per piece
+void buildAttackMaps(const Board& board, AttackMaps& attacks);
+
+// mobility, king safety & hanging pieces, midgame & endgame scores from white's point of view
+void evaluateAttacks(const Board& board, const AttackMaps& attacks, int& score_mg, int& score_eg);
+
+// attack maps against isSquareAttacked on the bench positions & build throughput
+void attackMapsTest();
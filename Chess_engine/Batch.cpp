@@ -0,0 +1,416 @@
+#include "Batch.hpp"
+#include "Board.hpp"
+#include "Evaluation.hpp"
+#include "Scaling.hpp"
+#include "Search.hpp"
+#include "Utility.hpp"
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+//##################################################################################################################
+//                                                     VARIABLES
+//##################################################################################################################
+
+enum BatchMode { batch_perft, batch_search, batch_eval };
+
+// everything a worker reuses from one line to the next
+struct BatchWorker {
+	Board board;
+	PawnTable pawn_table;
+
+	// move lists of every perft depth
+	std::vector<std::vector<uint64_t>> move_lists;
+
+	// search, its clock & table (search mode only)
+	std::unique_ptr<Search> search;
+	std::unique_ptr<TimeManager> time;
+	std::unique_ptr<TranspositionTable> tt;
+
+	// output not written yet & its file (the final output for the first chunk, a part file for the others)
+	std::string output;
+	FILE* file = nullptr;
+
+	BatchStats stats;
+	bool failed = false;
+};
+
+//##################################################################################################################
+//                                                     FUNCTIONS
+//##################################################################################################################
+
+// leaf nodes of the position of b, the lists of depth & below reused
+static uint64_t batchPerft(Board& b, int depth, std::vector<uint64_t>* move_lists)
+{
+	if (depth == 0)
+		return 1;
+
+	std::vector<uint64_t>* move_list = &move_lists[depth];
+	move_list->clear();
+	b.generateMoves(move_list);
+
+	uint64_t nodes = 0;
+	for (uint64_t move : *move_list) {
+		b.copyBoard();
+		if (!b.makeMove((int)move, all_moves)) {
+			b.clearCopy();
+			continue;
+		}
+		nodes += batchPerft(b, depth - 1, move_lists);
+		b.takeBack();
+	}
+	return nodes;
+}
+
+// write the buffered output of worker
+static void flushBatch(BatchWorker& worker)
+{
+	if (worker.output.empty())
+		return;
+	if (fwrite(worker.output.data(), 1, worker.output.size(), worker.file) != worker.output.size())
+		worker.failed = true;
+	worker.output.clear();
+}
+
+// file name of the output of chunk
+static std::string partName(const std::string& output, int chunk)
+{
+	return output + ".part" + std::to_string(chunk);
+}
+
+// analyse the lines of [begin, end) into the output of worker
+static void runChunk(BatchWorker& worker, const char* begin, const char* end, BatchMode mode, const BatchOptions& options)
+{
+	char number[32];
+
+	while (begin < end) {
+		const char* line_end = (const char*)memchr(begin, '\n', end - begin);
+		if (!line_end)
+			line_end = end;
+		const char* line = begin;
+		begin = line_end + 1;
+
+		// CRLF files & blank lines
+		size_t line_length = line_end - line;
+		while (line_length && (line[line_length - 1] == '\r' || line[line_length - 1] == ' ' || line[line_length - 1] == '\t'))
+			line_length--;
+		while (line_length && (*line == ' ' || *line == '\t')) {
+			line++;
+			line_length--;
+		}
+		if (!line_length)
+			continue;
+
+		worker.stats.lines++;
+		size_t length = 0;
+		FenError error = worker.board.parseFen(std::string_view(line, line_length), &length);
+		if (error != fen_ok) {
+			worker.stats.errors++;
+			worker.output.append(line, line_length);
+			worker.output += "; error ";
+			worker.output += fenErrorString(error);
+			worker.output += '\n';
+		}
+		else {
+			// the FEN part of the line, without the operations
+			while (length && line[length - 1] == ' ')
+				length--;
+			worker.output.append(line, length);
+
+			if (mode == batch_perft) {
+				uint64_t nodes = batchPerft(worker.board, options.depth, worker.move_lists.data());
+				worker.stats.nodes += nodes;
+				snprintf(number, sizeof(number), "; perft %d %llu\n", options.depth, (unsigned long long)nodes);
+				worker.output += number;
+			}
+			else if (mode == batch_eval) {
+				snprintf(number, sizeof(number), "; eval %d\n", evaluate(worker.board, &worker.pawn_table));
+				worker.output += number;
+			}
+			else {
+				SearchLimits limits;
+				limits.depth = options.depth;
+				limits.nodes = options.nodes;
+				limits.movetime = options.movetime;
+				worker.time->start(limits, worker.board.side());
+				worker.search->setPosition(worker.board);
+				SearchResult result = worker.search->searchPosition(options.depth ? options.depth : max_ply - 1, false);
+				worker.stats.nodes += result.nodes;
+
+				worker.output += "; bestmove ";
+				worker.output += result.best_move ? moveToString(result.best_move) : "0000";
+				worker.output += " score " + scoreToString(result.score);
+				snprintf(number, sizeof(number), " depth %d nodes %llu\n", result.depth, (unsigned long long)result.nodes);
+				worker.output += number;
+			}
+		}
+
+		if (worker.output.size() >= batch_output_buffer)
+			flushBatch(worker);
+	}
+	flushBatch(worker);
+}
+
+// append the part file name to out, then remove it
+static bool appendPart(const std::string& name, FILE* out)
+{
+	FILE* part = fopen(name.c_str(), "rb");
+	if (!part)
+		return false;
+
+	std::vector<char> buffer(batch_output_buffer);
+	bool written = true;
+	size_t read;
+	while ((read = fread(buffer.data(), 1, buffer.size(), part)) > 0)
+		written &= fwrite(buffer.data(), 1, read, out) == read;
+	fclose(part);
+	remove(name.c_str());
+	return written;
+}
+
+bool runBatch(const std::string& input, const std::string& output, const BatchOptions& options, BatchStats& stats)
+{
+	stats = BatchStats();
+
+	BatchMode mode;
+	if (options.mode == "perft")
+		mode = batch_perft;
+	else if (options.mode == "search")
+		mode = batch_search;
+	else if (options.mode == "eval")
+		mode = batch_eval;
+	else {
+		printf("batch: unknown mode %s (perft, search or eval)\n", options.mode.c_str());
+		return false;
+	}
+	if (mode == batch_perft && options.depth < 1) {
+		printf("batch: perft needs a depth\n");
+		return false;
+	}
+	if (mode == batch_search && !options.depth && !options.nodes && !options.movetime) {
+		printf("batch: search needs a depth, nodes or movetime limit\n");
+		return false;
+	}
+
+	// MappedFile can't map an empty file, which is an empty batch
+	MappedFile file;
+	if (!file.open(input)) {
+		FILE* check = fopen(input.c_str(), "rb");
+		bool empty = check && fgetc(check) == EOF;
+		if (check)
+			fclose(check);
+		if (!empty) {
+			printf("batch: can't read %s\n", input.c_str());
+			return false;
+		}
+	}
+	const char* data = (const char*)file.data();
+	size_t size = file.size();
+
+	bool to_stdout = output == "-";
+	FILE* out = to_stdout ? stdout : fopen(output.c_str(), "wb");
+	if (!out) {
+		printf("batch: can't write %s\n", output.c_str());
+		return false;
+	}
+
+	// no more workers than lines of a typical length
+	int threads = options.threads < 1 ? 1 : options.threads;
+	if ((size_t)threads > size / 64 + 1)
+		threads = (int)(size / 64 + 1);
+
+	// chunk t is [bounds[t], bounds[t + 1]), every bound but the ends right after a line feed
+	std::vector<size_t> bounds(threads + 1, size);
+	bounds[0] = 0;
+	for (int t = 1; t < threads; t++) {
+		size_t bound = size * t / threads;
+		if (bound < bounds[t - 1])
+			bound = bounds[t - 1];
+		const void* line_feed = bound < size ? memchr(data + bound, '\n', size - bound) : nullptr;
+		bounds[t] = line_feed ? (const char*)line_feed - data + 1 : size;
+	}
+
+	std::vector<std::unique_ptr<BatchWorker>> workers;
+	bool opened = true;
+	for (int t = 0; t < threads; t++) {
+		workers.emplace_back(new BatchWorker());
+		BatchWorker& worker = *workers.back();
+		worker.output.reserve(batch_output_buffer + 4096);
+		worker.file = t ? fopen(partName(output, t).c_str(), "wb") : out;
+		opened &= worker.file != nullptr;
+
+		if (mode == batch_perft) {
+			worker.move_lists.resize(options.depth + 1);
+			for (auto& list : worker.move_lists)
+				list.reserve(max_moves);
+		}
+		else if (mode == batch_search) {
+			worker.tt.reset(new TranspositionTable(options.hash_mb));
+			worker.time.reset(new TimeManager(1));
+			worker.search.reset(new Search());
+			worker.search->setTranspositionTable(worker.tt.get());
+			worker.search->setTimeManager(worker.time.get());
+		}
+	}
+
+	uint64_t start = get_time_ms();
+	if (opened) {
+		std::vector<std::thread> threads_running;
+		for (int t = 1; t < threads; t++)
+			threads_running.emplace_back(runChunk, std::ref(*workers[t]), data + bounds[t], data + bounds[t + 1], mode, std::cref(options));
+		runChunk(*workers[0], data + bounds[0], data + bounds[1], mode, options);
+		for (std::thread& thread : threads_running)
+			thread.join();
+	}
+
+	// the parts follow the first chunk in order
+	bool written = opened;
+	for (int t = 0; t < threads; t++) {
+		BatchWorker& worker = *workers[t];
+		written &= !worker.failed;
+		stats.lines += worker.stats.lines;
+		stats.errors += worker.stats.errors;
+		stats.nodes += worker.stats.nodes;
+		if (!t || !worker.file)
+			continue;
+		fclose(worker.file);
+		if (opened)
+			written &= appendPart(partName(output, t), out);
+		else
+			remove(partName(output, t).c_str());
+	}
+	written &= fflush(out) == 0;
+	if (!to_stdout)
+		written &= fclose(out) == 0;
+	stats.time_ms = get_time_ms() - start;
+
+	if (!written)
+		printf("batch: can't write %s\n", output.c_str());
+	return written;
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+void batchTest(int threads)
+{
+	printf("\n     Batch analysis\n\n");
+
+	// perft 3 of each position
+	struct known { const char* fen; uint64_t nodes; };
+	const known positions[] = {
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 8902 },
+		{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 97862 },
+		{ "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 2812 },
+		{ "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 9467 },
+		{ "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 62379 },
+		{ "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 89890 },
+	};
+	const int count = sizeof(positions) / sizeof(positions[0]);
+	const int repeats = 200;
+
+	// the known positions as EPD lines (operations, CRLF, blank lines), every 50th line invalid
+	std::string input_path = "batch_test_input.epd";
+	std::string output_path = "batch_test_output.txt";
+	std::vector<std::string> expected;
+	FILE* input = fopen(input_path.c_str(), "wb");
+	if (!input) {
+		printf("  can't write %s\n", input_path.c_str());
+		return;
+	}
+	for (int i = 0; i < repeats * count; i++) {
+		const known& position = positions[i % count];
+		if (i % 50 == 49) {
+			fprintf(input, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1\n");
+			expected.push_back("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1; error " + std::string(fenErrorString(fen_bad_side)));
+			continue;
+		}
+		fprintf(input, "%s%s%s", position.fen, i % 3 ? "" : " id \"known\";", i % 7 ? "\n" : "\r\n");
+		if (i % 11 == 0)
+			fprintf(input, "\n");
+		expected.push_back(std::string(position.fen) + "; perft 3 " + std::to_string(position.nodes));
+	}
+	fclose(input);
+
+	// the output line by line against the known counts
+	auto check = [&](const char* mode, int workers) {
+		BatchOptions options;
+		options.mode = mode;
+		options.depth = 3;
+		options.threads = workers;
+		BatchStats stats;
+		bool ran = runBatch(input_path, output_path, options, stats);
+
+		int mismatches = 0;
+		size_t lines = 0;
+		FILE* output = fopen(output_path.c_str(), "rb");
+		char line[256];
+		while (output && fgets(line, sizeof(line), output)) {
+			line[strcspn(line, "\n")] = 0;
+			if (!strcmp(mode, "perft") && (lines >= expected.size() || expected[lines] != line))
+				mismatches++;
+			lines++;
+		}
+		if (output)
+			fclose(output);
+		if (!strcmp(mode, "perft") && lines != expected.size())
+			mismatches++;
+
+		printf("  %-6s %3d threads  %s  %6llu lines  %4llu errors  %5llu ms  %9.0f lines/s  %s\n", mode, workers,
+			ran ? "ok    " : "failed", (unsigned long long)stats.lines, (unsigned long long)stats.errors,
+			(unsigned long long)stats.time_ms, stats.time_ms ? stats.lines * 1000.0 / stats.time_ms : 0.0,
+			strcmp(mode, "perft") ? "" : mismatches ? "mismatches" : "matches");
+	};
+
+	check("perft", 1);
+	check("perft", threads);
+	check("eval", 1);
+	check("eval", threads);
+	check("search", threads);
+
+	remove(input_path.c_str());
+	remove(output_path.c_str());
+	printf("\n");
+}
+
+void batchScalingTest(const std::string& input, const std::string& mode, int depth, int max_threads, const std::string& json_path)
+{
+	if (max_threads <= 0)
+		max_threads = std::thread::hardware_concurrency();
+
+	printf("\n     Batch scaling: %s %s, 1 to %d threads\n", mode.c_str(), input.c_str(), max_threads);
+
+	BatchOptions options;
+	options.mode = mode;
+	options.depth = depth;
+
+	// nodes of perft & search, lines of eval (no nodes)
+	std::string output_path = json_path + ".batch_output";
+	bool failed = false;
+	std::vector<ScalingPoint> points = runScaling([&](int threads) {
+		options.threads = threads;
+		BatchStats stats;
+		failed |= !runBatch(input, output_path, options, stats);
+		return mode == "eval" ? stats.lines : stats.nodes;
+	}, max_threads, 3);
+	remove(output_path.c_str());
+	if (failed)
+		return;
+	printScaling(points);
+
+	// perft counts the same trees at every thread count
+	if (mode == "perft")
+		for (const ScalingPoint& point : points)
+			if (point.nodes != points.front().nodes)
+				printf("    WARNING: %d threads counted %llu nodes\n\n", point.threads, (unsigned long long)point.nodes);
+
+	if (writeScalingJson(points, "batch " + mode + " " + std::to_string(depth) + " " + input, json_path))
+		std::cout << "Results written to " << json_path << std::endl;
+	else
+		std::cout << "Could not write " << json_path << std::endl;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/*
+		EPD batch analysis
+
+	The input file is memory mapped & cut into one line aligned chunk per worker thread. Every worker walks
+	its chunk with one Board (parseFen in place, no allocation per line), its own search, transposition &
+	pawn tables, and appends one result line per input line to an output buffer of its own, written to a
+	part file of its own whenever it fills up. No lock is taken per line: the part files are joined in
+	chunk order at the end, so the output follows the input line by line.
+
+		perft     <position>; perft <depth> <nodes>
+		search    <position>; bestmove <move> score <cp x or mate y> depth <depth> nodes <nodes>
+		eval      <position>; eval <cp, side to move>
+		invalid   <line>; error <fenErrorString>
+
+	<position> is the FEN part of the line (the EPD operations aren't copied), empty lines are skipped.
+*/
+
+// output written by a worker at once
+const size_t batch_output_buffer = 1 << 20;
+
+struct BatchOptions {
+	// perft, search or eval
+	std::string mode = "eval";
+
+	// perft depth, search depth (0: none)
+	int depth = 0;
+
+	// search node & time limits per line (0: none)
+	uint64_t nodes = 0;
+	uint64_t movetime = 0;
+
+	int threads = 1;
+
+	// transposition table of each worker (search)
+	int hash_mb = 16;
+};
+
+// counts of a batch run
+struct BatchStats {
+	uint64_t lines = 0;
+	uint64_t errors = 0;
+	uint64_t nodes = 0;
+	uint64_t time_ms = 0;
+};
+
+// analyse every line of input into output ("-" for the standard output), false when a file can't be used
+bool runBatch(const std::string& input, const std::string& output, const BatchOptions& options, BatchStats& stats);
+
+// perft results & line order against known counts at 1 & threads workers, lines per second of every mode
+void batchTest(int threads);
+
+// runBatch at 1, 2, 4, ... threads (nodes per second, lines per second for eval) written to json_path
+void batchScalingTest(const std::string& input, const std::string& mode, int depth, int max_threads, const std::string& json_path);
@@ -0,0 +1,317 @@
+#include "Bench.hpp"
+#include "Board.hpp"
+#include "Utility.hpp"
+#include "AllocTracker.hpp"
+#include "See.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+//##################################################################################################################
+//                                                     VARIABLES
+//##################################################################################################################
+
+// sink written by every benchmark so the compiler can't drop the measured calls
+volatile uint64_t bench_sink = 0;
+
+//##################################################################################################################
+//                                                     FUNCTIONS
+//##################################################################################################################
+
+const std::vector<BenchPosition>& benchPositions() {
+	static const std::vector<BenchPosition> positions = {
+		{ "start", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 " },
+		{ "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 " },
+		{ "killer", "rnbqkb1r/pp1p1pPp/8/2p1pP2/1P1P4/3P3P/P1P1P3/RNBQKBNR w KQkq e6 0 1" },
+		{ "cmk", "r2q1rk1/ppp2ppp/2n1bn2/2b1p3/3pP3/3P1NPP/PPP1NPB1/R1BQ1RK1 b - - 0 9 " },
+		{ "endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1 " },
+		{ "promotions", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1 " },
+		{ "middlegame", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8 " }
+	};
+	return positions;
+}
+
+// cost of one get_time_ns() pair, subtracted from per call timings
+static double timerOverhead() {
+	std::vector<uint64_t> samples;
+	for (int i = 0; i < 1000; ++i) {
+		uint64_t t0 = get_time_ns();
+		uint64_t t1 = get_time_ns();
+		samples.push_back(t1 - t0);
+	}
+	std::sort(samples.begin(), samples.end());
+	return (double)samples[samples.size() / 2];
+}
+
+// nearest rank percentile of sorted samples
+static double percentile(const std::vector<double>& sorted, double p) {
+	size_t rank = (size_t)std::ceil(p * sorted.size());
+	if (rank == 0) rank = 1;
+	return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+BenchResult benchMeasure(const std::string& primitive, const BenchPosition& position, const BenchConfig& config, BenchOp op, PerfCounters* counters) {
+	BenchResult result;
+	result.primitive = primitive;
+	result.position = position.name;
+	result.fen = position.fen;
+	result.repetitions = config.repetitions;
+
+	uint64_t calls = 0;
+
+	// warm caches and branch predictors
+	for (int rep = 0; rep < config.warmup; ++rep)
+		op(calls);
+
+	// counters only run during the timed repetitions
+	if (counters)
+		counters->reset();
+
+	// one sample (nanoseconds per call) per repetition
+	std::vector<double> samples;
+	samples.reserve(config.repetitions);
+	for (int rep = 0; rep < config.repetitions; ++rep) {
+		if (counters) counters->enable();
+		uint64_t elapsed = op(calls);
+		if (counters) counters->disable();
+		samples.push_back(calls ? (double)elapsed / calls : 0.0);
+	}
+	result.calls = calls;
+
+	if (counters)
+		result.counters = counters->read();
+
+	std::sort(samples.begin(), samples.end());
+	double sum = 0;
+	for (double s : samples) sum += s;
+
+	result.min_ns = samples.front();
+	result.median_ns = percentile(samples, 0.5);
+	result.mean_ns = sum / samples.size();
+	result.p99_ns = percentile(samples, 0.99);
+	result.max_ns = samples.back();
+	return result;
+}
+
+std::vector<BenchResult> runBench(const BenchConfig& config) {
+	std::vector<BenchResult> results;
+
+	Board board;
+	PerfCounters counters;
+	std::vector<uint64_t> move_list;
+	move_list.reserve(256);
+
+	// makeMove & takeBack can't be batched on their own, so they are timed per call
+	double overhead = timerOverhead();
+	auto net = [overhead](uint64_t t0, uint64_t t1) {
+		double elapsed = (double)(t1 - t0) - overhead;
+		return (uint64_t)(elapsed > 0 ? elapsed : 0);
+	};
+
+	for (const BenchPosition& position : benchPositions()) {
+		board.parse_fen(position.fen);
+
+		// parse_fen
+		results.push_back(benchMeasure("parse_fen", position, config, [&](uint64_t& calls) {
+			uint64_t t0 = get_time_ns();
+			for (int i = 0; i < config.batch; ++i)
+				board.parse_fen(position.fen);
+			uint64_t t1 = get_time_ns();
+			bench_sink += board.side();
+			calls = config.batch;
+			return t1 - t0;
+		}, &counters));
+
+		// generateMoves
+		results.push_back(benchMeasure("generateMoves", position, config, [&](uint64_t& calls) {
+			uint64_t t0 = get_time_ns();
+			for (int i = 0; i < config.batch; ++i) {
+				move_list.clear();
+				board.generateMoves(&move_list);
+			}
+			uint64_t t1 = get_time_ns();
+			bench_sink += move_list.size();
+			calls = config.batch;
+			return t1 - t0;
+		}, &counters));
+
+		// generateCaptures
+		results.push_back(benchMeasure("generateCaptures", position, config, [&](uint64_t& calls) {
+			uint64_t t0 = get_time_ns();
+			for (int i = 0; i < config.batch; ++i) {
+				move_list.clear();
+				board.generateCaptures(&move_list);
+			}
+			uint64_t t1 = get_time_ns();
+			bench_sink += move_list.size();
+			calls = config.batch;
+			return t1 - t0;
+		}, &counters));
+
+		// see, every capture of the position (if there is any)
+		move_list.clear();
+		board.generateCaptures(&move_list);
+		if (!move_list.empty()) {
+			results.push_back(benchMeasure("see", position, config, [&](uint64_t& calls) {
+				int64_t value = 0;
+				uint64_t t0 = get_time_ns();
+				for (uint64_t move : move_list)
+					value += see(board, (int)move);
+				uint64_t t1 = get_time_ns();
+				bench_sink += value;
+				calls = move_list.size();
+				return t1 - t0;
+			}, &counters));
+		}
+
+		// isSquareAttacked, every square by both sides
+		results.push_back(benchMeasure("isSquareAttacked", position, config, [&](uint64_t& calls) {
+			uint64_t attacked = 0;
+			uint64_t t0 = get_time_ns();
+			for (int square = 0; square < 64; ++square) {
+				attacked += board.isSquareAttacked(square, white);
+				attacked += board.isSquareAttacked(square, black);
+			}
+			uint64_t t1 = get_time_ns();
+			bench_sink += attacked;
+			calls = 128;
+			return t1 - t0;
+		}, &counters));
+
+		move_list.clear();
+		board.generateMoves(&move_list);
+
+		// makeMove, every pseudo legal move of the position
+		// (counters cover the whole loop, including the copyBoard/takeBack around the timed call)
+		results.push_back(benchMeasure("makeMove", position, config, [&](uint64_t& calls) {
+			uint64_t elapsed = 0;
+			for (uint64_t move : move_list) {
+				board.copyBoard();
+				uint64_t t0 = get_time_ns();
+				int legal = board.makeMove(move, all_moves);
+				uint64_t t1 = get_time_ns();
+				elapsed += net(t0, t1);
+				legal ? board.takeBack() : board.clearCopy();
+			}
+			calls = move_list.size();
+			return elapsed;
+		}, &counters));
+
+		// takeBack, after every legal move of the position
+		results.push_back(benchMeasure("takeBack", position, config, [&](uint64_t& calls) {
+			uint64_t elapsed = 0;
+			calls = 0;
+			for (uint64_t move : move_list) {
+				board.copyBoard();
+				if (!board.makeMove(move, all_moves)) {
+					board.clearCopy();
+					continue;
+				}
+				uint64_t t0 = get_time_ns();
+				board.takeBack();
+				uint64_t t1 = get_time_ns();
+				elapsed += net(t0, t1);
+				calls++;
+			}
+			return elapsed;
+		}, &counters));
+	}
+
+	return results;
+}
+
+// counter value per call of a result
+static double perCall(const BenchResult& result, int event) {
+	uint64_t total_calls = result.calls * result.repetitions;
+	return total_calls ? (double)result.counters.values[event] / total_calls : 0.0;
+}
+
+void printBenchResults(const std::vector<BenchResult>& results) {
+	printf("\n  %-18s %-12s %8s %10s %10s %10s %10s %10s %10s %10s\n\n", "primitive", "position", "calls", "median ns", "p99 ns", "mean ns",
+		"Mcalls/s", "cycles", "instr", "br miss");
+	for (const BenchResult& result : results) {
+		printf("  %-18s %-12s %8llu %10.1f %10.1f %10.1f %10.2f", result.primitive.c_str(), result.position.c_str(),
+			(unsigned long long)result.calls, result.median_ns, result.p99_ns, result.mean_ns,
+			result.median_ns > 0 ? 1e3 / result.median_ns : 0.0);
+
+		// per call hardware counters, "-" when not permitted
+		for (int event : { perf_cycles, perf_instructions, perf_branch_misses }) {
+			if (result.counters.valid[event])
+				printf(" %10.1f", perCall(result, event));
+			else
+				printf(" %10s", "-");
+		}
+		printf("\n");
+	}
+	printf("\n");
+}
+
+bool writeBenchJson(const std::vector<BenchResult>& results, const BenchConfig& config, const std::string& path) {
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+	out << "{\n";
+	out << "  \"timestamp\": " << timestamp << ",\n";
+	out << "  \"config\": { \"warmup\": " << config.warmup << ", \"repetitions\": " << config.repetitions
+		<< ", \"batch\": " << config.batch << " },\n";
+	out << "  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); ++i) {
+		const BenchResult& result = results[i];
+		out << "    { \"primitive\": \"" << result.primitive << "\""
+			<< ", \"position\": \"" << result.position << "\""
+			<< ", \"fen\": \"" << result.fen << "\""
+			<< ", \"calls\": " << result.calls
+			<< ", \"repetitions\": " << result.repetitions
+			<< ", \"min_ns\": " << result.min_ns
+			<< ", \"median_ns\": " << result.median_ns
+			<< ", \"mean_ns\": " << result.mean_ns
+			<< ", \"p99_ns\": " << result.p99_ns
+			<< ", \"max_ns\": " << result.max_ns
+			<< ", \"counters_per_call\": {";
+
+		// only the counters that could be opened
+		bool first = true;
+		for (int event = 0; event < perf_event_count; ++event) {
+			if (!result.counters.valid[event])
+				continue;
+			out << (first ? " " : ", ") << "\"" << perfEventName(event) << "\": " << perCall(result, event);
+			first = false;
+		}
+		out << (first ? "" : " ") << "}"
+			<< " }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n";
+	out << "}\n";
+	return true;
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+bool benchTest(std::string json_path, int repetitions) {
+	BenchConfig config;
+	if (repetitions > 0)
+		config.repetitions = repetitions;
+
+	printf("\n     Primitives benchmark\n");
+
+	resetHotRegionAllocations();
+	std::vector<BenchResult> results = runBench(config);
+	printBenchResults(results);
+
+	// the benchmarked primitives must not allocate
+	bool alloc_free = checkHotRegions("bench");
+
+	if (writeBenchJson(results, config, json_path))
+		std::cout << "Results written to " << json_path << std::endl;
+	else
+		std::cout << "Could not write " << json_path << std::endl;
+
+	return alloc_free;
+}
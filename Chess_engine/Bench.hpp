@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include "PerfCounters.hpp"
+
+// named FEN position of the benchmark corpus
+struct BenchPosition {
+	std::string name;
+	std::string fen;
+};
+
+// benchmark settings
+struct BenchConfig {
+	// untimed repetitions run before sampling
+	int warmup = 20;
+	// timed repetitions, one sample each
+	int repetitions = 200;
+	// calls per repetition for the cheap primitives
+	int batch = 256;
+};
+
+// per call timing summary of one primitive on one position
+struct BenchResult {
+	std::string primitive;
+	std::string position;
+	std::string fen;
+	uint64_t calls = 0;
+	int repetitions = 0;
+	double min_ns = 0;
+	double median_ns = 0;
+	double mean_ns = 0;
+	double p99_ns = 0;
+	double max_ns = 0;
+	// hardware counters summed over the timed repetitions
+	PerfSample counters;
+};
+
+// benchmark operation: runs the primitive, sets the number of calls made and returns the elapsed nanoseconds
+typedef std::function<uint64_t(uint64_t& calls)> BenchOp;
+
+// positions used by the benchmarks
+const std::vector<BenchPosition>& benchPositions();
+
+BenchResult benchMeasure(const std::string& primitive, const BenchPosition& position, const BenchConfig& config, BenchOp op, PerfCounters* counters = nullptr);
+
+std::vector<BenchResult> runBench(const BenchConfig& config);
+
+void printBenchResults(const std::vector<BenchResult>& results);
+
+bool writeBenchJson(const std::vector<BenchResult>& results, const BenchConfig& config, const std::string& path);
+
+bool benchTest(std::string json_path, int repetitions);
@@ -0,0 +1,291 @@
+#include "Bitbase.hpp"
+#include "Utility.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//##################################################################################################################
+//                                                     VARIABLES
+//##################################################################################################################
+
+// results while generating, flags so the results of the successors can be or'ed together
+enum { kpk_invalid = 0, kpk_unknown = 1, kpk_draw = 2, kpk_win = 4 };
+
+static inline int kpkIndex(int side, int black_king, int white_king, int pawn) {
+	return side | (black_king << 1) | (white_king << 7) | ((pawn % 8) << 13) | ((pawn / 8 - 1) << 15);
+}
+
+static inline void kpkDecode(int index, int& side, int& black_king, int& white_king, int& pawn) {
+	side = index & 1;
+	black_king = (index >> 1) & 63;
+	white_king = (index >> 7) & 63;
+	pawn = ((index >> 15) + 1) * 8 + ((index >> 13) & 3);
+}
+
+// a queen or rook on the promotion square neither stalemates nor gets taken
+static bool kpkPromotionWins(const Moves& moves, int black_king, int white_king, int promotion)
+{
+	uint64_t covered = moves.getKingAttacks(white_king);
+	if ((moves.getKingAttacks(black_king) & (1ULL << promotion)) && !(covered & (1ULL << promotion)))
+		return false;
+
+	// the black king doesn't block the lines it flees along
+	uint64_t flight = moves.getKingAttacks(black_king) & ~covered;
+	uint64_t occupancy = (1ULL << white_king) | (1ULL << black_king);
+	uint64_t queen_checks = moves.getQueenAttacks(promotion, occupancy) & (1ULL << black_king);
+	uint64_t rook_checks = moves.getRookAttacks(promotion, occupancy) & (1ULL << black_king);
+	return queen_checks || (flight & ~moves.getQueenAttacks(promotion, 1ULL << white_king))
+		|| rook_checks || (flight & ~moves.getRookAttacks(promotion, 1ULL << white_king));
+}
+
+// invalid positions & the results known without looking at the moves
+static uint8_t kpkInitial(const Moves& moves, int side, int black_king, int white_king, int pawn)
+{
+	uint64_t white_king_attacks = moves.getKingAttacks(white_king);
+	uint64_t black_king_attacks = moves.getKingAttacks(black_king);
+	uint64_t pawn_attacks = moves.getPawnAttacks(white, pawn);
+
+	// kings on the same or neighbouring squares, a king on the pawn, black in check with white to move
+	if (white_king == black_king || (white_king_attacks & (1ULL << black_king)) || white_king == pawn || black_king == pawn
+		|| (side == white && (pawn_attacks & (1ULL << black_king))))
+		return kpk_invalid;
+
+	if (side == white) {
+		int promotion = pawn - 8;
+		if (pawn / 8 == 1 && promotion != white_king && promotion != black_king && kpkPromotionWins(moves, black_king, white_king, promotion))
+			return kpk_win;
+	}
+	else {
+		// stalemate or the pawn taken
+		if (!(black_king_attacks & ~(white_king_attacks | pawn_attacks)))
+			return kpk_draw;
+		if ((black_king_attacks & (1ULL << pawn)) && !(white_king_attacks & (1ULL << pawn)))
+			return kpk_draw;
+	}
+	return kpk_unknown;
+}
+
+// white wins if a move reaches a win & draws once every move draws, black the other way round
+static uint8_t kpkClassify(const std::vector<uint8_t>& results, const Moves& moves, int side, int black_king, int white_king, int pawn)
+{
+	int good = (side == white) ? kpk_win : kpk_draw;
+	int bad = (side == white) ? kpk_draw : kpk_win;
+	int result = kpk_invalid;
+
+	uint64_t bitboard = moves.getKingAttacks((side == white) ? white_king : black_king);
+	while (bitboard) {
+		int square = get_ls1b_index(bitboard);
+		result |= (side == white) ? results[kpkIndex(black, black_king, square, pawn)] : results[kpkIndex(white, square, white_king, pawn)];
+		bitboard &= bitboard - 1;
+	}
+
+	// pushes short of the promotion (an occupied target square is an invalid position)
+	if (side == white && pawn / 8 > 1) {
+		result |= results[kpkIndex(black, black_king, white_king, pawn - 8)];
+		if (pawn / 8 == 6 && pawn - 8 != white_king && pawn - 8 != black_king)
+			result |= results[kpkIndex(black, black_king, white_king, pawn - 16)];
+	}
+	return (result & good) ? good : (result & kpk_unknown) ? kpk_unknown : bad;
+}
+
+// retrograde analysis until no position changes, the positions left unknown are draws
+static std::vector<uint32_t> initKpkBitbase() {
+	const Moves& moves = sharedMoves();
+	std::vector<uint8_t> results(kpk_size);
+	int side, black_king, white_king, pawn;
+
+	for (int index = 0; index < kpk_size; index++) {
+		kpkDecode(index, side, black_king, white_king, pawn);
+		results[index] = kpkInitial(moves, side, black_king, white_king, pawn);
+	}
+
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (int index = 0; index < kpk_size; index++) {
+			if (results[index] != kpk_unknown)
+				continue;
+			kpkDecode(index, side, black_king, white_king, pawn);
+			results[index] = kpkClassify(results, moves, side, black_king, white_king, pawn);
+			changed |= results[index] != kpk_unknown;
+		}
+	}
+
+	std::vector<uint32_t> bitbase(kpk_size / 32);
+	for (int index = 0; index < kpk_size; index++)
+		if (results[index] == kpk_win)
+			bitbase[index >> 5] |= 1u << (index & 31);
+	return bitbase;
+}
+
+const std::vector<uint32_t> kpk_bitbase = initKpkBitbase();
+
+//##################################################################################################################
+//                                                     FUNCTIONS
+//##################################################################################################################
+
+bool probeKpk(int strong_side, int strong_king, int pawn, int weak_king, int side)
+{
+	// white pawn on the queen side
+	if (strong_side == black) {
+		strong_king ^= 56;
+		pawn ^= 56;
+		weak_king ^= 56;
+		side ^= 1;
+	}
+	if (pawn % 8 > 3) {
+		strong_king ^= 7;
+		pawn ^= 7;
+		weak_king ^= 7;
+	}
+	int index = kpkIndex(side, weak_king, strong_king, pawn);
+	return kpk_bitbase[index >> 5] & (1u << (index & 31));
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+static std::string kpkFen(int side, int black_king, int white_king, int pawn)
+{
+	std::string fen;
+	for (int row = 0; row < 8; row++) {
+		int empty = 0;
+		for (int file = 0; file < 8; file++) {
+			int square = row * 8 + file;
+			char piece = (square == white_king) ? 'K' : (square == black_king) ? 'k' : (square == pawn) ? 'P' : 0;
+			if (!piece) {
+				empty++;
+				continue;
+			}
+			if (empty)
+				fen += (char)('0' + empty);
+			empty = 0;
+			fen += piece;
+		}
+		if (empty)
+			fen += (char)('0' + empty);
+		if (row < 7)
+			fen += '/';
+	}
+	return fen + ((side == white) ? " w - - 0 1" : " b - - 0 1");
+}
+
+void kpkTest()
+{
+	const int successor_win = -1, successor_draw = -2;
+
+	uint64_t start = get_time_ns();
+	std::vector<uint32_t> bitbase = initKpkBitbase();
+	double generation_ms = (double)(get_time_ns() - start) / 1e6;
+
+	// the legal moves of every position from the move generator: a successor position, or a result for
+	// captures, promotions & positions without moves
+	start = get_time_ns();
+	Board b;
+	std::vector<uint64_t> move_list, replies;
+	std::vector<int> successors, first_successor(kpk_size + 1, 0);
+	std::vector<uint8_t> valid(kpk_size, 0);
+	int side, black_king, white_king, pawn;
+
+	for (int index = 0; index < kpk_size; index++) {
+		first_successor[index] = (int)successors.size();
+		kpkDecode(index, side, black_king, white_king, pawn);
+		if (white_king == black_king || white_king == pawn || black_king == pawn)
+			continue;
+		b.parse_fen(kpkFen(side, black_king, white_king, pawn));
+		if (b.isSquareAttacked((side == white) ? black_king : white_king, side))
+			continue;
+		valid[index] = 1;
+
+		move_list.clear();
+		b.generateMoves(&move_list);
+		int legal = 0;
+		for (uint64_t move : move_list) {
+			b.copyBoard();
+			if (!b.makeMove((int)move, all_moves)) {
+				b.clearCopy();
+				continue;
+			}
+			legal++;
+
+			int promoted = get_move_promoted(move);
+			if (get_move_capture(move) || promoted == N || promoted == B)
+				successors.push_back(successor_draw);
+			else if (promoted) {
+				// a queen or rook wins unless black takes it or is stalemated
+				int result = b.inCheck() ? successor_win : successor_draw;
+				replies.clear();
+				b.generateMoves(&replies);
+				for (uint64_t reply : replies) {
+					b.copyBoard();
+					if (!b.makeMove((int)reply, all_moves)) {
+						b.clearCopy();
+						continue;
+					}
+					b.takeBack();
+					result = get_move_capture(reply) ? successor_draw : successor_win;
+					if (result == successor_draw)
+						break;
+				}
+				successors.push_back(result);
+			}
+			else
+				successors.push_back(kpkIndex(b.side(), get_ls1b_index(b.bitboards()[k]), get_ls1b_index(b.bitboards()[K]),
+					get_ls1b_index(b.bitboards()[P])));
+			b.takeBack();
+		}
+
+		// mate can't happen, stalemate draws
+		if (!legal)
+			successors.push_back(b.inCheck() ? ((side == white) ? successor_draw : successor_win) : successor_draw);
+	}
+	first_successor[kpk_size] = (int)successors.size();
+
+	// solve by repeated passes
+	std::vector<uint8_t> results(kpk_size, kpk_unknown);
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (int index = 0; index < kpk_size; index++) {
+			if (!valid[index] || results[index] != kpk_unknown)
+				continue;
+			int good = (index & 1) == white ? kpk_win : kpk_draw;
+			int bad = (index & 1) == white ? kpk_draw : kpk_win;
+			int found = 0;
+			for (int i = first_successor[index]; i < first_successor[index + 1]; i++) {
+				int successor = successors[i];
+				found |= (successor == successor_win) ? (int)kpk_win : (successor == successor_draw) ? (int)kpk_draw : (int)results[successor];
+			}
+			int result = (found & good) ? good : (found & kpk_unknown) ? kpk_unknown : bad;
+			if (result != kpk_unknown) {
+				results[index] = result;
+				changed = true;
+			}
+		}
+	}
+	double brute_force_ms = (double)(get_time_ns() - start) / 1e6;
+
+	// every position, the mirrored one & the colour flipped one
+	int positions = 0, wins = 0, mismatches = 0, symmetry_mismatches = 0;
+	for (int index = 0; index < kpk_size; index++) {
+		if (!valid[index])
+			continue;
+		kpkDecode(index, side, black_king, white_king, pawn);
+		bool win = results[index] == kpk_win;
+		positions++;
+		wins += win;
+		mismatches += (bool)(bitbase[index >> 5] & (1u << (index & 31))) != win;
+		mismatches += probeKpk(white, white_king, pawn, black_king, side) != win;
+		symmetry_mismatches += probeKpk(white, white_king ^ 7, pawn ^ 7, black_king ^ 7, side) != win;
+		symmetry_mismatches += probeKpk(black, white_king ^ 56, pawn ^ 56, black_king ^ 56, side ^ 1) != win;
+	}
+
+	printf("\n     KPK bitbase\n\n");
+	printf("  size               %d bytes\n", (int)(bitbase.size() * sizeof(uint32_t)));
+	printf("  generation         %.1f ms\n", generation_ms);
+	printf("  brute force        %.1f ms\n", brute_force_ms);
+	printf("  positions          %d (%d wins, %d draws)\n", positions, wins, positions - wins);
+	printf("  mismatches         %d\n", mismatches);
+	printf("  symmetry           %d\n\n", symmetry_mismatches);
+}
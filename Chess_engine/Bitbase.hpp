@@ -0,0 +1,23 @@
+#pragma once
+#include "Board.hpp"
+
+/*
+		  kpk bitbase index
+
+	0000 0000 0000 0000 0001    side to move               1 bit
+	0000 0000 0000 0111 1110    black (weak) king square   6 bits
+	0000 0001 1111 1000 0000    white (strong) king        6 bits
+	0000 0110 0000 0000 0000    pawn file a-d              2 bits
+	0011 1000 0000 0000 0000    pawn rank 7-2 (0-5)        3 bits
+
+	the white pawn is kept on the queen side by mirroring the files, a black pawn by flipping the board.
+	One bit per position (win or draw), 2 * 64 * 64 * 4 * 6 bits = 24 KB.
+*/
+
+const int kpk_size = 2 * 64 * 64 * 4 * 6;
+
+// exact result of king & pawn against king: the side with the pawn wins, any squares & side to move
+bool probeKpk(int strong_side, int strong_king, int pawn, int weak_king, int side);
+
+// bitbase against a brute force solution built with the move generator, every position
+void kpkTest();
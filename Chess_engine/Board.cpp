@@ -1,6 +1,13 @@
 #pragma once
 #include "Board.hpp"
-#include <map>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include "PerfCounters.hpp"
+#include "TranspositionTable.hpp"
+#include "TimeManager.hpp"
+#include "Evaluation.hpp"
+#include "Material.hpp"
 
 //##################################################################################################################
 //                                                     VARIABLES
@@ -21,30 +28,6 @@
 // ASCII pieces
 std::string ascii_pieces = "PNBRQKpnbrqk";
 
-// encode pieces
-enum { P, N, B, R, Q, K, p, n, b, r, q, k };
-
-// sides to move (colors)
-enum { white, black, both };
-
-// bishop and rook
-enum { rook, bishop };
-
-// convert ASCII character pieces to encoded constants
-std::map<char, int> char_pieces{ 
-	{'P', P}, 
-	{'N', N}, 
-	{'B', B}, 
-	{'R', R}, 
-	{'K', K}, 
-	{'Q', Q}, 
-	{'p', p}, 
-	{'n', n}, 
-	{'b', b}, 
-	{'r', r}, 
-	{'k', k}, 
-	{'q', q}};
-
 // convert squares to coordinates
 std::vector<std::string> square_to_coordinates = {
 	"a8", "b8", "c8", "d8", "e8", "f8", "g8", "h8",
@@ -57,58 +40,6 @@ std::vector<std::string> square_to_coordinates = {
 	"a1", "b1", "c1", "d1", "e1", "f1", "g1", "h1",
 };
 
-/*
-		  binary move bits                               hexidecimal constants
-
-	0000 0000 0000 0000 0011 1111    source square       0x3f
-	0000 0000 0000 1111 1100 0000    target square       0xfc0
-	0000 0000 1111 0000 0000 0000    piece               0xf000
-	0000 1111 0000 0000 0000 0000    promoted piece      0xf0000
-	0001 0000 0000 0000 0000 0000    capture flag        0x100000
-	0010 0000 0000 0000 0000 0000    double push flag    0x200000
-	0100 0000 0000 0000 0000 0000    enpassant flag      0x400000
-	1000 0000 0000 0000 0000 0000    castling flag       0x800000
-*/
-
-// encode move
-#define encode_move(source, target, piece, promoted, capture, double, enpassant, castling) \
-    (source) |          \
-    (target << 6) |     \
-    (piece << 12) |     \
-    (promoted << 16) |  \
-    (capture << 20) |   \
-    (double << 21) |    \
-    (enpassant << 22) | \
-    (castling << 23)    \
-
-// extract source square
-#define get_move_source(move) (move & 0x3f)
-
-// extract target square
-#define get_move_target(move) ((move & 0xfc0) >> 6)
-
-// extract piece
-#define get_move_piece(move) ((move & 0xf000) >> 12)
-
-// extract promoted piece
-#define get_move_promoted(move) ((move & 0xf0000) >> 16)
-
-// extract capture flag
-#define get_move_capture(move) (move & 0x100000)
-// ((move >> 20) & 0b1)
-
-// extract double pawn push flag
-#define get_move_double(move) (move & 0x200000)
-
-// extract enpassant flag
-#define get_move_enpassant(move) (move & 0x400000)
-
-// extract castling flag
-#define get_move_castling(move) (move & 0x800000)
-
-// move types
-enum { all_moves, only_captures };
-
 /*
 						   castling   move     in      in
 							  right update     binary  decimal
@@ -138,147 +69,513 @@ const int castling_rights[64] = {
 };
 
 
+// zobrist random keys
+struct zobristKeys {
+	uint64_t piece[12][64];
+	uint64_t enpassant[64];
+	uint64_t castle[16];
+	uint64_t side;
+};
+
+// fixed seed xorshift, so hash keys are the same on every run
+static zobristKeys initZobristKeys() {
+	zobristKeys keys;
+	uint64_t state = 1070372ULL;
+	auto next = [&state]() {
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 2685821657736338717ULL;
+	};
+
+	for (int piece = P; piece <= k; piece++)
+		for (int square = 0; square < 64; square++)
+			keys.piece[piece][square] = next();
+	for (int square = 0; square < 64; square++)
+		keys.enpassant[square] = next();
+	for (int castle = 0; castle < 16; castle++)
+		keys.castle[castle] = next();
+	keys.side = next();
+	return keys;
+}
+
+const zobristKeys zobrist = initZobristKeys();
+
+
 //##################################################################################################################
 //                                                     BOARD METHODS
 //##################################################################################################################
 
 void Board::add_piece(uint32_t piece_val, uint32_t file, uint32_t rank) {
 	m_bitboards[piece_val] = set_bit(m_bitboards[piece_val], (7-rank) * 8 + file);
+	if (piece_val % 6 == P)
+		m_pawn_key ^= zobrist.piece[piece_val][(7 - rank) * 8 + file];
+	addMaterial(piece_val);
+	addPieceScore(piece_val, (7 - rank) * 8 + file);
 }
 
-std::vector<uint64_t> Board::getOccupationBoard() {
+// a count beyond its digit goes to the overflow instead of the key
+inline void Board::addMaterial(int piece) {
+	if (count_bits(m_bitboards[piece]) > max_material_count[piece])
+		m_material_overflow++;
+	else
+		m_material_key += material_key_weight[piece];
+}
+
+inline void Board::removeMaterial(int piece) {
+	if (count_bits(m_bitboards[piece]) >= max_material_count[piece])
+		m_material_overflow--;
+	else
+		m_material_key -= material_key_weight[piece];
+}
+
+inline void Board::addPieceScore(int piece, int square) {
+	m_score_mg += pst.mg[piece][square];
+	m_score_eg += pst.eg[piece][square];
+	m_phase += phase_increment[piece];
+}
+
+inline void Board::removePieceScore(int piece, int square) {
+	m_score_mg -= pst.mg[piece][square];
+	m_score_eg -= pst.eg[piece][square];
+	m_phase -= phase_increment[piece];
+}
+
+std::array<uint64_t, 3> Board::getOccupationBoard() {
 	return m_occupancies;
 }
 
-void Board::parse_fen(std::string fen)
+// piece of each FEN character, -1 for the characters that aren't pieces
+static std::array<int8_t, 256> initFenPieces() {
+	std::array<int8_t, 256> pieces;
+	pieces.fill(-1);
+	for (int piece = P; piece <= k; piece++)
+		pieces[(unsigned char)ascii_pieces[piece]] = piece;
+	return pieces;
+}
+
+const std::array<int8_t, 256> fen_pieces = initFenPieces();
+
+const char* fenErrorString(int error)
 {
-    // reset board position (bitboards)
-    std::fill(m_bitboards.begin(), m_bitboards.end(), 0);
+	static const char* strings[] = { "ok", "missing field", "bad piece", "bad rank", "not 8 ranks", "bad side to move",
+		"bad castling rights", "bad en passant square", "bad halfmove clock", "bad fullmove number", "not one king per side",
+		"pawn on the first or last rank", "too many pieces", "side not to move in check", "trailing characters" };
+	return (error >= fen_ok && error <= fen_trailing_characters) ? strings[error] : "unknown error";
+}
 
-    // reset occupancies (bitboards)
-    std::fill(m_occupancies.begin(), m_occupancies.end(), 0);
+FenError Board::parse_fen(std::string_view fen)
+{
+	return setFen(fen, false, nullptr);
+}
 
-    // reset game state variables
-    m_side = 0;
-    m_enpassant = -1;
-    m_castle = 0;
+FenError Board::parseFen(std::string_view fen, size_t* length)
+{
+	return setFen(fen, true, length);
+}
 
-	uint16_t index=0;
-    // loop over board ranks
-    for (int rank = 0; rank < 8; rank++)
-    {
-		for (int file = 0; file < 8; file++)
-		{
-			// init current square
-			int square = rank * 8 + file;
+FenError Board::setFen(std::string_view fen, bool validate, size_t* length)
+{
+	const size_t size = fen.size();
+	size_t index = 0;
+
+	// skip the spaces before a field, false at the end of the string
+	auto nextField = [&]() {
+		while (index < size && fen[index] == ' ')
+			index++;
+		return index < size;
+	};
+	auto fieldEnd = [&]() { return index >= size || fen[index] == ' ' || fen[index] == ';'; };
+
+	// piece placement, rank 8 first: the keys, scores & counts are summed on the way
+	std::array<uint64_t, 12> bitboards = {};
+	int counts[12] = {};
+	uint64_t hash_key = 0, pawn_key = 0;
+	int score_mg = 0, score_eg = 0, phase = 0;
+	if (!nextField())
+		return fen_missing_field;
+	int rank = 0, file = 0;
+	bool after_digit = false;
+	for (; !fieldEnd(); index++) {
+		unsigned char c = fen[index];
+		if (c == '/') {
+			if (file != 8)
+				return fen_bad_rank;
+			if (++rank > 7)
+				return fen_bad_rank_count;
+			file = 0;
+			after_digit = false;
+		}
+		else if (c >= '1' && c <= '8') {
+			// two digits in a row are one run written wrongly
+			if (validate && after_digit)
+				return fen_bad_rank;
+			file += c - '0';
+			after_digit = true;
+		}
+		else {
+			int piece = fen_pieces[c];
+			if (piece < 0)
+				return fen_bad_piece;
+			if (file < 8) {
+				int square = rank * 8 + file;
+				bitboards[piece] |= 1ULL << square;
+				counts[piece]++;
+				hash_key ^= zobrist.piece[piece][square];
+				if (piece == P || piece == p)
+					pawn_key ^= zobrist.piece[piece][square];
+				score_mg += pst.mg[piece][square];
+				score_eg += pst.eg[piece][square];
+				phase += phase_increment[piece];
+			}
+			file++;
+			after_digit = false;
+		}
+		if (file > 8)
+			return fen_bad_rank;
+	}
+	if (rank != 7)
+		return fen_bad_rank_count;
+	if (file != 8)
+		return fen_bad_rank;
+
+	// side to move
+	if (!nextField())
+		return fen_missing_field;
+	int side = (fen[index] == 'w') ? white : (fen[index] == 'b') ? black : -1;
+	index++;
+	if (side < 0 || !fieldEnd())
+		return fen_bad_side;
+
+	// castling rights, KQkq order
+	if (!nextField())
+		return fen_missing_field;
+	int castle = 0;
+	if (fen[index] == '-')
+		index++;
+	else {
+		for (int last = 0; !fieldEnd(); index++) {
+			// the lenient parser reads K-kq & the like as well
+			if (!validate && fen[index] == '-')
+				continue;
+			int right = (fen[index] == 'K') ? 1 : (fen[index] == 'Q') ? 2 : (fen[index] == 'k') ? 4 : (fen[index] == 'q') ? 8 : 0;
+			if (!right || (validate && right <= last))
+				return fen_bad_castling;
+			castle |= right;
+			last = right;
+		}
+	}
+	if (!fieldEnd())
+		return fen_bad_castling;
+
+	// en passant square
+	if (!nextField())
+		return fen_missing_field;
+	int enpassant = -1;
+	if (fen[index] == '-')
+		index++;
+	else {
+		if (index + 1 >= size || fen[index] < 'a' || fen[index] > 'h' || fen[index + 1] < '1' || fen[index + 1] > '8')
+			return fen_bad_enpassant;
+		enpassant = (8 - (fen[index + 1] - '0')) * 8 + (fen[index] - 'a');
+		index += 2;
+	}
+	if (!fieldEnd())
+		return fen_bad_enpassant;
+
+	// halfmove clock & fullmove number, optional. A field starting with a digit that isn't a number (the 1-0 of
+	// an EPD line) is an error in a FEN & the start of the operations in an EPD line
+	int fifty = 0, fullmove = 1;
+	size_t end = index;
+	enum { number_ok, not_number, number_overflow };
+	auto parseNumber = [&](int& number) {
+		number = 0;
+		for (; index < size && fen[index] >= '0' && fen[index] <= '9'; index++)
+			if ((number = number * 10 + (fen[index] - '0')) > INT16_MAX)
+				return number_overflow;
+		return fieldEnd() ? number_ok : not_number;
+	};
+	if (nextField() && fen[index] >= '0' && fen[index] <= '9') {
+		int parsed = parseNumber(fifty);
+		if (parsed == number_overflow || (parsed == not_number && !length))
+			return fen_bad_halfmove;
+		if (parsed == number_ok) {
+			end = index;
+			if (nextField() && fen[index] >= '0' && fen[index] <= '9') {
+				parsed = parseNumber(fullmove);
+				if (parsed == number_overflow || (parsed == not_number && !length) || (parsed == number_ok && validate && fullmove == 0))
+					return fen_bad_fullmove;
+				if (parsed == number_ok)
+					end = index;
+				else
+					fullmove = 1;
+			}
+		}
+		else
+			fifty = 0;
+	}
 
-			// match ascii pieces within FEN string
-			if ((fen[index] >= 'a' && fen[index] <= 'z') || (fen[index] >= 'A' && fen[index] <= 'Z'))
-			{
-				// init piece type
-				int piece = char_pieces[fen[index]];
+	// the rest of an EPD line (operations) is left to the caller
+	if (length)
+		*length = end;
+	else if (validate) {
+		index = end;
+		if (nextField())
+			return fen_trailing_characters;
+	}
 
-				// set piece on corresponding bitboard
-				set_bit(m_bitboards[piece], square);
+	if (validate) {
+		uint64_t white_pieces = 0, black_pieces = 0;
+		for (int piece = P; piece <= K; piece++) {
+			white_pieces |= bitboards[piece];
+			black_pieces |= bitboards[piece + 6];
+		}
+		uint64_t occupancy = white_pieces | black_pieces;
+
+		if (counts[K] != 1 || counts[k] != 1)
+			return fen_bad_kings;
+		if ((bitboards[P] | bitboards[p]) & 0xff000000000000ffULL)
+			return fen_bad_pawns;
+		if (counts[P] + counts[N] + counts[B] + counts[R] + counts[Q] > 15 || counts[p] + counts[n] + counts[b] + counts[r] + counts[q] > 15
+			|| counts[P] > 8 || counts[p] > 8)
+			return fen_too_many_pieces;
+
+		// the king (e1, e8) & rook (h1, a1, h8, a8) of every right on their squares
+		if (((castle & 1) && !(get_bit(bitboards[K], 60) && get_bit(bitboards[R], 63)))
+			|| ((castle & 2) && !(get_bit(bitboards[K], 60) && get_bit(bitboards[R], 56)))
+			|| ((castle & 4) && !(get_bit(bitboards[k], 4) && get_bit(bitboards[r], 7)))
+			|| ((castle & 8) && !(get_bit(bitboards[k], 4) && get_bit(bitboards[r], 0))))
+			return fen_bad_castling;
+
+		// behind the pawn that just made a double push, the square & the one it came from empty
+		if (enpassant != -1) {
+			int pawn = (side == white) ? enpassant + 8 : enpassant - 8;
+			int from = (side == white) ? enpassant - 8 : enpassant + 8;
+			if (enpassant / 8 != ((side == white) ? 2 : 5) || !get_bit(bitboards[(side == white) ? p : P], pawn)
+				|| get_bit(occupancy, enpassant) || get_bit(occupancy, from))
+				return fen_bad_enpassant;
+		}
 
-				// increment index to FEN string
-				index++;
-			}
+		// the side not to move can't be in check
+		int king = get_ls1b_index(bitboards[(side == white) ? k : K]);
+		int attacker = (side == white) ? P : p;
+		if ((m_moves->getPawnAttacks(side ^ 1, king) & bitboards[attacker])
+			|| (m_moves->getKnightAttacks(king) & bitboards[attacker + N])
+			|| (m_moves->getBishopAttacks(king, occupancy) & (bitboards[attacker + B] | bitboards[attacker + Q]))
+			|| (m_moves->getRookAttacks(king, occupancy) & (bitboards[attacker + R] | bitboards[attacker + Q]))
+			|| (m_moves->getKingAttacks(king) & bitboards[attacker + K]))
+			return fen_opponent_in_check;
+	}
 
-			// match empty square numbers within FEN string
-			if (fen[index] >= '0' && fen[index] <= '9')
-			{
-				// init offset (convert char 0 to int 0)
-				int offset = fen[index] - '0';
-
-				// define piece variable
-				int piece = -1;
-
-				// loop over all piece bitboards
-				for (int bb_piece = P; bb_piece <= k; bb_piece++)
-				{
-					// if there is a piece on current square
-					if (get_bit(m_bitboards[bb_piece], square))
-						// get piece code
-						piece = bb_piece;
-				}
+	// valid, set up the board
+	m_bitboards = bitboards;
+	m_occupancies = {};
+	for (int piece = P; piece <= K; piece++) {
+		m_occupancies[white] |= m_bitboards[piece];
+		m_occupancies[black] |= m_bitboards[piece + 6];
+	}
+	m_occupancies[both] = m_occupancies[white] | m_occupancies[black];
+
+	m_side = side;
+	m_enpassant = enpassant;
+	m_castle = castle;
+	m_fifty = fifty;
+	m_fullmove = fullmove;
+	m_plies_from_null = 0;
+	m_key_history.clear();
+	m_copy_stack.clear();
+
+	// keys & scores of the pieces, the rest of the state added
+	if (enpassant != -1)
+		hash_key ^= zobrist.enpassant[enpassant];
+	hash_key ^= zobrist.castle[castle];
+	if (side == black)
+		hash_key ^= zobrist.side;
+	m_hash_key = hash_key;
+	m_pawn_key = pawn_key;
+
+	// material key, the counts beyond its digits as overflow
+	m_material_key = 0;
+	m_material_overflow = 0;
+	for (int piece = P; piece <= k; piece++) {
+		int digit = counts[piece] < max_material_count[piece] ? counts[piece] : max_material_count[piece];
+		m_material_key += material_key_weight[piece] * digit;
+		m_material_overflow += counts[piece] - digit;
+	}
 
-				// on empty current square
-				if (piece == -1)
-					// decrement file
-					file--;
+	m_score_mg = score_mg;
+	m_score_eg = score_eg;
+	m_phase = phase;
 
-				// adjust file counter
-				file += offset;
+	// init nnue accumulator
+	if (m_network)
+		refreshAccumulator();
 
-				// increment pointer to FEN string
-				index++;
+	return fen_ok;
+}
+
+// decimal digits of a non negative number, returns the end
+static char* writeNumber(char* out, int number)
+{
+	char digits[8];
+	int count = 0;
+	do {
+		digits[count++] = (char)('0' + number % 10);
+		number /= 10;
+	} while (number);
+	while (count)
+		*out++ = digits[--count];
+	return out;
+}
+
+int Board::writeFen(char* fen) const
+{
+	// mailbox of the piece characters
+	char squares[64] = {};
+	for (int piece = P; piece <= k; piece++)
+		for (uint64_t bitboard = m_bitboards[piece]; bitboard; bitboard &= bitboard - 1)
+			squares[get_ls1b_index(bitboard)] = ascii_pieces[piece];
+
+	char* out = fen;
+	for (int rank = 0; rank < 8; rank++) {
+		int empty = 0;
+		for (int file = 0; file < 8; file++) {
+			char piece = squares[rank * 8 + file];
+			if (!piece) {
+				empty++;
+				continue;
 			}
-			// match rank separator
-			if (fen[index] == '/')
-				// increment pointer to FEN string
-				index++;
+			if (empty)
+				*out++ = (char)('0' + empty);
+			empty = 0;
+			*out++ = piece;
 		}
-    }
+		if (empty)
+			*out++ = (char)('0' + empty);
+		*out++ = (rank < 7) ? '/' : ' ';
+	}
 
-	// got to parsing side to move (increment pointer to FEN string)
-	index++;
+	*out++ = (m_side == white) ? 'w' : 'b';
+	*out++ = ' ';
+	if (!m_castle)
+		*out++ = '-';
+	for (int right = 0; right < 4; right++)
+		if (m_castle & (1 << right))
+			*out++ = "KQkq"[right];
+	*out++ = ' ';
+	if (m_enpassant == -1)
+		*out++ = '-';
+	else {
+		*out++ = (char)('a' + m_enpassant % 8);
+		*out++ = (char)('8' - m_enpassant / 8);
+	}
 
-	// parse side to move
-	(fen[index] == 'w') ? (m_side = white) : (m_side = black);
+	*out++ = ' ';
+	out = writeNumber(out, m_fifty);
+	*out++ = ' ';
+	out = writeNumber(out, m_fullmove);
+	*out = 0;
+	return (int)(out - fen);
+}
 
-	// go to parsing castling rights
-	index += 2;
+std::string Board::toFen() const
+{
+	char fen[max_fen_length];
+	return std::string(fen, writeFen(fen));
+}
 
-	// parse castling rights
-	while (fen[index] != ' ')
-	{
-		switch (fen[index])
-		{
-		case 'K': m_castle |= 1; break;
-		case 'Q': m_castle |= 2; break;
-		case 'k': m_castle |= 4; break;
-		case 'q': m_castle |= 8; break;
-		case '-': break;
-		}
+void Board::setNetwork(const NnueNetwork* network)
+{
+	m_network = network;
+	m_accumulators.clear();
+	if (m_network) {
+		m_accumulators.reserve(max_copy_stack);
+		refreshAccumulator();
+	}
+	else
+		m_accumulators.shrink_to_fit();
+}
 
-		// increment pointer to FEN string
-		index++;
+void Board::refreshAccumulator()
+{
+	m_accumulators.clear();
+	m_accumulators.emplace_back();
+	m_network->refresh(m_bitboards, m_accumulators.back());
+}
+
+uint64_t Board::generateHashKey() const
+{
+	uint64_t key = 0ULL;
+
+	// pieces
+	for (int piece = P; piece <= k; piece++) {
+		uint64_t bitboard = m_bitboards[piece];
+		while (bitboard) {
+			int square = get_ls1b_index(bitboard);
+			key ^= zobrist.piece[piece][square];
+			pop_bit(bitboard, square);
+		}
 	}
 
-	index++;
+	// enpassant square
+	if (m_enpassant != -1)
+		key ^= zobrist.enpassant[m_enpassant];
 
-	// parse enpassant square
-	if (fen[index] != '-')
-	{
-		//std::cout << fen[index] << ";" << fen[index+1] << std::endl;
-		// parse enpassant file & rank
-		int file = fen[index] - 'a';
-		int rank = 8 - (fen[index+1] - '0');
+	// castling rights
+	key ^= zobrist.castle[m_castle];
 
-		//std::cout << file << ";" << rank << std::endl;
+	// side to move
+	if (m_side == black)
+		key ^= zobrist.side;
 
-		// init enpassant square
-		m_enpassant = rank * 8 + file;
-	}
-	// no enpassant square
-	else
-		m_enpassant = -1;
+	return key;
+}
 
-	// loop over white pieces bitboards
-	for (int piece = P; piece <= K; piece++)
-		// populate white occupancy bitboard
-		m_occupancies[white] |= m_bitboards[piece];
+uint64_t Board::generatePawnKey() const
+{
+	uint64_t key = 0ULL;
+
+	// pawns of both sides
+	for (int piece : { P, p }) {
+		uint64_t bitboard = m_bitboards[piece];
+		while (bitboard) {
+			int square = get_ls1b_index(bitboard);
+			key ^= zobrist.piece[piece][square];
+			pop_bit(bitboard, square);
+		}
+	}
 
-	// loop over black pieces bitboards
-	for (int piece = p; piece <= k; piece++)
-		// populate white occupancy bitboard
-		m_occupancies[black] |= m_bitboards[piece];
+	return key;
+}
 
-	// init all occupancies
-	m_occupancies[both] |= m_occupancies[white];
-	m_occupancies[both] |= m_occupancies[black];
+void Board::generateMaterialKey(uint32_t& key, int& overflow) const
+{
+	key = 0;
+	overflow = 0;
+
+	// counts up to the digit limit in the key, the rest as overflow
+	for (int piece = P; piece <= k; piece++) {
+		int count = count_bits(m_bitboards[piece]);
+		int digit = count < max_material_count[piece] ? count : max_material_count[piece];
+		key += material_key_weight[piece] * digit;
+		overflow += count - digit;
+	}
+}
 
+void Board::generateScores(int& score_mg, int& score_eg, int& phase) const
+{
+	score_mg = score_eg = phase = 0;
+
+	for (int piece = P; piece <= k; piece++) {
+		uint64_t bitboard = m_bitboards[piece];
+		while (bitboard) {
+			int square = get_ls1b_index(bitboard);
+			score_mg += pst.mg[piece][square];
+			score_eg += pst.eg[piece][square];
+			phase += phase_increment[piece];
+			pop_bit(bitboard, square);
+		}
+	}
 }
 
 void Board::plot() {
@@ -327,137 +624,188 @@ void Board::plot() {
 		(m_castle & 2) ? 'Q' : '-',
 		(m_castle & 4) ? 'k' : '-',
 		(m_castle & 8) ? 'q' : '-');
-	
+
+	// print halfmove clock & move number
+	printf("     Halfmove:   %d\n", m_fifty);
+	printf("     Fullmove:   %d\n\n", m_fullmove);
 }
 
 void Board::copyBoard() {
-	m_bs.m_bitboards = m_bitboards;
-	m_bs.m_occupancies = m_occupancies;
-	m_bs.m_side = m_side;
-	m_bs.m_enpassant = m_enpassant;
-	m_bs.m_castle = m_castle;
-	m_copy_stack.push(m_bs);
+	HotRegion hot_region(hot_make_unmake);
+	m_copy_stack.emplace_back();
+	boardStruct& bs = m_copy_stack.back();
+	bs.m_bitboards = m_bitboards;
+	bs.m_occupancies = m_occupancies;
+	bs.m_side = m_side;
+	bs.m_enpassant = m_enpassant;
+	bs.m_castle = m_castle;
+	bs.m_fifty = m_fifty;
+	bs.m_fullmove = m_fullmove;
+	bs.m_plies_from_null = m_plies_from_null;
+	bs.m_history_size = (uint32_t)m_key_history.size();
+	bs.m_accumulator_size = (uint32_t)m_accumulators.size();
+	bs.m_hash_key = m_hash_key;
+	bs.m_pawn_key = m_pawn_key;
+	bs.m_material_key = m_material_key;
+	bs.m_material_overflow = m_material_overflow;
+	bs.m_score_mg = m_score_mg;
+	bs.m_score_eg = m_score_eg;
+	bs.m_phase = m_phase;
 }
 
 void Board::takeBack() {
-	m_bs = m_copy_stack.top();
-	m_copy_stack.pop();
-	m_bitboards = m_bs.m_bitboards;
-	m_occupancies = m_bs.m_occupancies;
-	m_side = m_bs.m_side;
-	m_enpassant = m_bs.m_enpassant;
-	m_castle = m_bs.m_castle;
+	HotRegion hot_region(hot_make_unmake);
+	const boardStruct& bs = m_copy_stack.back();
+	m_bitboards = bs.m_bitboards;
+	m_occupancies = bs.m_occupancies;
+	m_side = bs.m_side;
+	m_enpassant = bs.m_enpassant;
+	m_castle = bs.m_castle;
+	m_fifty = bs.m_fifty;
+	m_fullmove = bs.m_fullmove;
+	m_plies_from_null = bs.m_plies_from_null;
+	m_key_history.resize(bs.m_history_size);
+	m_accumulators.resize(bs.m_accumulator_size);
+	m_hash_key = bs.m_hash_key;
+	m_pawn_key = bs.m_pawn_key;
+	m_material_key = bs.m_material_key;
+	m_material_overflow = bs.m_material_overflow;
+	m_score_mg = bs.m_score_mg;
+	m_score_eg = bs.m_score_eg;
+	m_phase = bs.m_phase;
+	m_copy_stack.pop_back();
 }
 
 void Board::clearCopy() {
-	m_copy_stack.pop();
+	m_copy_stack.pop_back();
 }
 
-bool Board::isSquareAttacked(int square, int side) {
+bool Board::isSquareAttacked(int square, int side) const {
 
 	// attacked by white pawns
-	if ((side == white) && (m_moves.getPawnAttacks(black,square) & m_bitboards[P])) return 1;
+	if ((side == white) && (m_moves->getPawnAttacks(black,square) & m_bitboards[P])) return 1;
 
 	// attacked by black pawns
-	if ((side == black) && (m_moves.getPawnAttacks(white, square) & m_bitboards[p])) return 1;
+	if ((side == black) && (m_moves->getPawnAttacks(white, square) & m_bitboards[p])) return 1;
 
 	// attacked by knights
-	if (m_moves.getKnightAttacks(square) & ((side == white) ? m_bitboards[N] : m_bitboards[n])) return 1;
+	if (m_moves->getKnightAttacks(square) & ((side == white) ? m_bitboards[N] : m_bitboards[n])) return 1;
 
 	// attacked by bishops
-	if (m_moves.getBishopAttacks(square, m_occupancies[both]) & ((side == white) ? m_bitboards[B] : m_bitboards[b])) return 1;
+	if (m_moves->getBishopAttacks(square, m_occupancies[both]) & ((side == white) ? m_bitboards[B] : m_bitboards[b])) return 1;
 
 	// attacked by rooks
-	if (m_moves.getRookAttacks(square, m_occupancies[both]) & ((side == white) ? m_bitboards[R] : m_bitboards[r])) return 1;
+	if (m_moves->getRookAttacks(square, m_occupancies[both]) & ((side == white) ? m_bitboards[R] : m_bitboards[r])) return 1;
 
 	// attacked by queens
-	if (m_moves.getQueenAttacks(square, m_occupancies[both]) & ((side == white) ? m_bitboards[Q] : m_bitboards[q])) return 1;
+	if (m_moves->getQueenAttacks(square, m_occupancies[both]) & ((side == white) ? m_bitboards[Q] : m_bitboards[q])) return 1;
 
 	// attacked by kings
-	if (m_moves.getKingAttacks(square) & ((side == white) ? m_bitboards[K] : m_bitboards[k])) return 1;
+	if (m_moves->getKingAttacks(square) & ((side == white) ? m_bitboards[K] : m_bitboards[k])) return 1;
 
 	// by default return false
 	return false;
 }
 
+uint64_t Board::attackersTo(int square, uint64_t occupancy) const {
+	return (m_moves->getPawnAttacks(black, square) & m_bitboards[P])
+		| (m_moves->getPawnAttacks(white, square) & m_bitboards[p])
+		| (m_moves->getKnightAttacks(square) & (m_bitboards[N] | m_bitboards[n]))
+		| (m_moves->getBishopAttacks(square, occupancy) & (m_bitboards[B] | m_bitboards[b] | m_bitboards[Q] | m_bitboards[q]))
+		| (m_moves->getRookAttacks(square, occupancy) & (m_bitboards[R] | m_bitboards[r] | m_bitboards[Q] | m_bitboards[q]))
+		| (m_moves->getKingAttacks(square) & (m_bitboards[K] | m_bitboards[k]));
+}
+
+bool Board::inCheck() const {
+	return isSquareAttacked(get_ls1b_index(m_bitboards[(m_side == white) ? K : k]), m_side ^ 1);
+}
+
 //##################################################################################################################
 //                                                     MOVES GENERATION
 //##################################################################################################################
 
-void Board::generateMoves(std::vector<uint64_t>* move_list)
+void Board::generateMoves(std::vector<uint64_t>* move_list) const
 {
+	HotRegion hot_region(hot_movegen);
+
+	// define source & target squares
+	uint8_t source_square, target_square;
+
+	// define current piece's bitboard copy & it's attacks
+	uint64_t bitboard, attacks;
+
 	// loop over all the bitboards
 	for (uint8_t piece = P; piece <= k; piece++)
 	{
 		// init piece bitboard copy
-		m_bitboard = m_bitboards[piece];
+		bitboard = m_bitboards[piece];
 
 		// generate white pawns & white king castling moves
 		if (m_side == white)
 		{
 			// Loop over all white pawn
 			if (piece == P) {
-				while (m_bitboard) {
+				while (bitboard) {
 					// init source square
-					m_source_square = get_ls1b_index(m_bitboard);
+					source_square = get_ls1b_index(bitboard);
 					//init target square
-					m_target_square = m_source_square - 8;
+					target_square = source_square - 8;
 
-					//Check if m_target_square is inside the board and empty
-					if (!(m_target_square < 0) && !get_bit(m_occupancies[both], m_target_square)) {
+					//Check if target_square is inside the board and empty
+					if (!(target_square < 0) && !get_bit(m_occupancies[both], target_square)) {
 						//pawn promotion if the pawn is in rank 7
-						if (m_source_square >= 8 && m_source_square<=15) {
+						if (source_square >= 8 && source_square<=15) {
 							// add moves to move_list
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, Q, 0, 0, 0, 0));
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, R, 0, 0, 0, 0));
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, B, 0, 0, 0, 0));
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, N, 0, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, Q, 0, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, R, 0, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, B, 0, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, N, 0, 0, 0, 0));
 						}
 						else {
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, 0, 0, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
 							
-							if (m_source_square >= 48 && m_source_square <= 55 && !get_bit(m_occupancies[both], m_target_square - 8)) {
-								move_list->push_back(encode_move(m_source_square, m_target_square-8, piece, 0, 0, 1, 0, 0));
+							if (source_square >= 48 && source_square <= 55 && !get_bit(m_occupancies[both], target_square - 8)) {
+								move_list->push_back(encode_move(source_square, target_square-8, piece, 0, 0, 1, 0, 0));
 							}
 						}
 					}
 
 					//Get pawn attacks
-					m_attacks = m_moves.getPawnAttacks(white, m_source_square) & m_occupancies[black];
+					attacks = m_moves->getPawnAttacks(white, source_square) & m_occupancies[black];
 
 					//Capture moves
-					while (m_attacks) {
+					while (attacks) {
 						//Get target square
-						m_target_square = get_ls1b_index(m_attacks);
+						target_square = get_ls1b_index(attacks);
 
 						//pawn promotion if the pawn is in rank 7
-						if (m_source_square >= 8 && m_source_square <= 15) {
+						if (source_square >= 8 && source_square <= 15) {
 							// add moves to move_list
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, Q, 1, 0, 0, 0));
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, R, 1, 0, 0, 0));
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, B, 1, 0, 0, 0));
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, N, 1, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, Q, 1, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, R, 1, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, B, 1, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, N, 1, 0, 0, 0));
 						}
 						else {
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, 0, 1, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
 						}
 
 						// pop ls1b index
-						pop_bit(m_attacks, m_target_square);
+						pop_bit(attacks, target_square);
 					}
 
 					//Generate enpassant captures
 					if (m_enpassant != -1) {
-						uint64_t enpassant_attacks = m_moves.getPawnAttacks(white, m_source_square) & (1ULL << m_enpassant);
+						uint64_t enpassant_attacks = m_moves->getPawnAttacks(white, source_square) & (1ULL << m_enpassant);
 
 						if (enpassant_attacks) {
 							uint64_t target_enpassant = get_ls1b_index(enpassant_attacks);
-							move_list->push_back(encode_move(m_source_square, target_enpassant, piece, 0, 0, 0, 1, 0));
+							move_list->push_back(encode_move(source_square, target_enpassant, piece, 0, 1, 0, 1, 0));
 						}
 					}
 
 					// pop source square
-					pop_bit(m_bitboard, m_source_square);
+					pop_bit(bitboard, source_square);
 				}
 			}
 		
@@ -493,67 +841,67 @@ void Board::generateMoves(std::vector<uint64_t>* move_list)
 		{
 			// Loop over all white pawn
 			if (piece == p) {
-				while (m_bitboard) {
+				while (bitboard) {
 					// init source square
-					m_source_square = get_ls1b_index(m_bitboard);
+					source_square = get_ls1b_index(bitboard);
 					//init target square
-					m_target_square = m_source_square + 8;
+					target_square = source_square + 8;
 
-					//Check if m_target_square is inside the board and empty
-					if (!(m_target_square > 63) && !get_bit(m_occupancies[both], m_target_square)) {
+					//Check if target_square is inside the board and empty
+					if (!(target_square > 63) && !get_bit(m_occupancies[both], target_square)) {
 						//pawn promotion if the pawn is in rank 7
-						if (m_source_square >= 48 && m_source_square <= 55) {
+						if (source_square >= 48 && source_square <= 55) {
 							// add moves to move_list
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, q, 0, 0, 0, 0));
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, r, 0, 0, 0, 0));
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, b, 0, 0, 0, 0));
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, n, 0, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, q, 0, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, r, 0, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, b, 0, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, n, 0, 0, 0, 0));
 						}
 						else {
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, 0, 0, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
 
-							if (m_source_square >= 8 && m_source_square <= 15 && !get_bit(m_occupancies[both], m_target_square + 8)) {
-								move_list->push_back(encode_move(m_source_square, m_target_square+8, piece, 0, 0, 1, 0, 0));
+							if (source_square >= 8 && source_square <= 15 && !get_bit(m_occupancies[both], target_square + 8)) {
+								move_list->push_back(encode_move(source_square, target_square+8, piece, 0, 0, 1, 0, 0));
 							}
 						}
 					}
 
 					//Get pawn attacks
-					m_attacks = m_moves.getPawnAttacks(black, m_source_square) & m_occupancies[white];
+					attacks = m_moves->getPawnAttacks(black, source_square) & m_occupancies[white];
 
 					//Capture moves
-					while (m_attacks) {
+					while (attacks) {
 						//Get target square
-						m_target_square = get_ls1b_index(m_attacks);
+						target_square = get_ls1b_index(attacks);
 
 						//pawn promotion if the pawn is in rank 7
-						if (m_source_square >= 48 && m_source_square <= 55) {
+						if (source_square >= 48 && source_square <= 55) {
 							// add moves to move_list
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, q, 1, 0, 0, 0));
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, r, 1, 0, 0, 0));
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, b, 1, 0, 0, 0));
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, n, 1, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, q, 1, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, r, 1, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, b, 1, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, n, 1, 0, 0, 0));
 						}
 						else {
-							move_list->push_back(encode_move(m_source_square, m_target_square, piece, 0, 1, 0, 0, 0));
+							move_list->push_back(encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
 						}
 
 						// pop ls1b index
-						pop_bit(m_attacks, m_target_square);
+						pop_bit(attacks, target_square);
 					}
 
 					//Generate enpassant captures
 					if (m_enpassant != -1) {
-						uint64_t enpassant_attacks = m_moves.getPawnAttacks(black, m_source_square) & (1ULL << m_enpassant);
+						uint64_t enpassant_attacks = m_moves->getPawnAttacks(black, source_square) & (1ULL << m_enpassant);
 
 						if (enpassant_attacks) {
 							uint64_t target_enpassant = get_ls1b_index(enpassant_attacks);
-							move_list->push_back(encode_move(m_source_square, target_enpassant, piece, 0, 1, 0, 1, 0));
+							move_list->push_back(encode_move(source_square, target_enpassant, piece, 0, 1, 0, 1, 0));
 						}
 					}
 
 					// pop source square
-					pop_bit(m_bitboard, m_source_square);
+					pop_bit(bitboard, source_square);
 				}
 			}
 
@@ -586,219 +934,578 @@ void Board::generateMoves(std::vector<uint64_t>* move_list)
 
 		// genarate knight moves
 		if ((m_side == white) ? piece == N : piece == n) {
-			while (m_bitboard) {
+			while (bitboard) {
 				// init source square
-				m_source_square = get_ls1b_index(m_bitboard);
+				source_square = get_ls1b_index(bitboard);
 
-				m_attacks = m_moves.getKnightAttacks(m_source_square) & ((m_side==white) ? ~m_occupancies[white] : ~m_occupancies[black]);
+				attacks = m_moves->getKnightAttacks(source_square) & ((m_side==white) ? ~m_occupancies[white] : ~m_occupancies[black]);
 
-				while (m_attacks) {
+				while (attacks) {
 					//Get target square
-					m_target_square = get_ls1b_index(m_attacks);
+					target_square = get_ls1b_index(attacks);
 
-					if (get_bit(m_occupancies[!m_side], m_target_square)) {
-						move_list->push_back(encode_move(m_source_square, m_target_square, piece, 0, 1, 0, 0, 0));
+					if (get_bit(m_occupancies[!m_side], target_square)) {
+						move_list->push_back(encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
 					}
 					else {
-						move_list->push_back(encode_move(m_source_square, m_target_square, piece, 0, 0, 0, 0, 0));
+						move_list->push_back(encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
 					}
 
 					// pop ls1b index
-					pop_bit(m_attacks, m_target_square);
+					pop_bit(attacks, target_square);
 				}
 
 				// pop source square
-				pop_bit(m_bitboard, m_source_square);
+				pop_bit(bitboard, source_square);
 			}
 		}
 
 		// generate bishop moves
 		if ((m_side == white) ? piece == B : piece == b) {
-			while (m_bitboard) {
+			while (bitboard) {
 				// init source square
-				m_source_square = get_ls1b_index(m_bitboard);
+				source_square = get_ls1b_index(bitboard);
 
 				//init attacks
-				m_attacks = m_moves.getBishopAttacks(m_source_square, m_occupancies[both]) & ((m_side == white) ? ~m_occupancies[white] : ~m_occupancies[black]);
+				attacks = m_moves->getBishopAttacks(source_square, m_occupancies[both]) & ((m_side == white) ? ~m_occupancies[white] : ~m_occupancies[black]);
 
-				while (m_attacks) {
+				while (attacks) {
 					//Get target square
-					m_target_square = get_ls1b_index(m_attacks);
+					target_square = get_ls1b_index(attacks);
 
-					if (get_bit(m_occupancies[!m_side], m_target_square)) {
-						move_list->push_back(encode_move(m_source_square, m_target_square, piece, 0, 1, 0, 0, 0));
+					if (get_bit(m_occupancies[!m_side], target_square)) {
+						move_list->push_back(encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
 					}
 					else {
-						move_list->push_back(encode_move(m_source_square, m_target_square, piece, 0, 0, 0, 0, 0));
+						move_list->push_back(encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
 					}
 
 					// pop ls1b index
-					pop_bit(m_attacks, m_target_square);
+					pop_bit(attacks, target_square);
 				}
 
 				// pop source square
-				pop_bit(m_bitboard, m_source_square);
+				pop_bit(bitboard, source_square);
 			}
 		}
 
 		// generate rook moves
 		if ((m_side == white) ? piece == R : piece == r) {
-			while (m_bitboard) {
+			while (bitboard) {
 				// init source square
-				m_source_square = get_ls1b_index(m_bitboard);
+				source_square = get_ls1b_index(bitboard);
 
 				//init attacks
-				m_attacks = m_moves.getRookAttacks(m_source_square, m_occupancies[both]) & ((m_side == white) ? ~m_occupancies[white] : ~m_occupancies[black]);
+				attacks = m_moves->getRookAttacks(source_square, m_occupancies[both]) & ((m_side == white) ? ~m_occupancies[white] : ~m_occupancies[black]);
 
-				while (m_attacks) {
+				while (attacks) {
 					//Get target square
-					m_target_square = get_ls1b_index(m_attacks);
+					target_square = get_ls1b_index(attacks);
 
-					if (get_bit(m_occupancies[!m_side], m_target_square)) {
-						move_list->push_back(encode_move(m_source_square, m_target_square, piece, 0, 1, 0, 0, 0));
+					if (get_bit(m_occupancies[!m_side], target_square)) {
+						move_list->push_back(encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
 					}
 					else {
-						move_list->push_back(encode_move(m_source_square, m_target_square, piece, 0, 0, 0, 0, 0));
+						move_list->push_back(encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
 					}
 
 					// pop ls1b index
-					pop_bit(m_attacks, m_target_square);
+					pop_bit(attacks, target_square);
 				}
 
 				// pop source square
-				pop_bit(m_bitboard, m_source_square);
+				pop_bit(bitboard, source_square);
 			}
 		}
 
 		// generate queen moves
 		if ((m_side == white) ? piece == Q : piece == q) {
-			while (m_bitboard) {
+			while (bitboard) {
 				// init source square
-				m_source_square = get_ls1b_index(m_bitboard);
+				source_square = get_ls1b_index(bitboard);
 
 				//init attacks
-				m_attacks = m_moves.getQueenAttacks(m_source_square, m_occupancies[both]) & ((m_side == white) ? ~m_occupancies[white] : ~m_occupancies[black]);
+				attacks = m_moves->getQueenAttacks(source_square, m_occupancies[both]) & ((m_side == white) ? ~m_occupancies[white] : ~m_occupancies[black]);
 
-				while (m_attacks) {
+				while (attacks) {
 					//Get target square
-					m_target_square = get_ls1b_index(m_attacks);
+					target_square = get_ls1b_index(attacks);
 
-					if (get_bit(m_occupancies[!m_side], m_target_square)) {
-						move_list->push_back(encode_move(m_source_square, m_target_square, piece, 0, 1, 0, 0, 0));
+					if (get_bit(m_occupancies[!m_side], target_square)) {
+						move_list->push_back(encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
 					}
 					else {
-						move_list->push_back(encode_move(m_source_square, m_target_square, piece, 0, 0, 0, 0, 0));
+						move_list->push_back(encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
 					}
 
 					// pop ls1b index
-					pop_bit(m_attacks, m_target_square);
+					pop_bit(attacks, target_square);
 				}
 
 				// pop source square
-				pop_bit(m_bitboard, m_source_square);
+				pop_bit(bitboard, source_square);
 			}
 		}
 
 		// generate king moves
 		if ((m_side == white) ? piece == K : piece == k) {
-			while (m_bitboard) {
+			while (bitboard) {
 				// init source square
-				m_source_square = get_ls1b_index(m_bitboard);
+				source_square = get_ls1b_index(bitboard);
 
 				//init attacks
-				m_attacks = m_moves.getKingAttacks(m_source_square) & ((m_side == white) ? ~m_occupancies[white] : ~m_occupancies[black]);
+				attacks = m_moves->getKingAttacks(source_square) & ((m_side == white) ? ~m_occupancies[white] : ~m_occupancies[black]);
 
-				while (m_attacks) {
+				while (attacks) {
 					//Get target square
-					m_target_square = get_ls1b_index(m_attacks);
+					target_square = get_ls1b_index(attacks);
 
-					if (get_bit(m_occupancies[!m_side], m_target_square)) {
-						move_list->push_back(encode_move(m_source_square, m_target_square, piece, 0, 1, 0, 0, 0));
+					if (get_bit(m_occupancies[!m_side], target_square)) {
+						move_list->push_back(encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
 					}
 					else {
-						move_list->push_back(encode_move(m_source_square, m_target_square, piece, 0, 0, 0, 0, 0));
+						move_list->push_back(encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
 					}
 					// pop ls1b index
-					pop_bit(m_attacks, m_target_square);
+					pop_bit(attacks, target_square);
 				}
 				// pop source square
-				pop_bit(m_bitboard, m_source_square);
+				pop_bit(bitboard, source_square);
+			}
+		}
+	}
+}
+
+void Board::generateCaptures(std::vector<uint64_t>* move_list) const
+{
+	HotRegion hot_region(hot_movegen);
+
+	// define source & target squares
+	uint8_t source_square, target_square;
+
+	// define current piece's bitboard copy & it's attacks
+	uint64_t bitboard, attacks;
+
+	// side dependent pieces & squares
+	uint8_t pawn = (m_side == white) ? P : p;
+	uint8_t king = (m_side == white) ? K : k;
+	uint64_t enemies = m_occupancies[m_side ^ 1];
+	int pawn_push = (m_side == white) ? -8 : 8;
+
+	// the rank a pawn promotes from
+	uint64_t promotion_rank = (m_side == white) ? 0x000000000000FF00ULL : 0x00FF000000000000ULL;
+
+	// pawn captures, promotions & enpassant
+	bitboard = m_bitboards[pawn];
+	while (bitboard) {
+		// init source square
+		source_square = get_ls1b_index(bitboard);
+		bool promotion = get_bit(promotion_rank, source_square);
+
+		// promotion by push
+		target_square = source_square + pawn_push;
+		if (promotion && !get_bit(m_occupancies[both], target_square)) {
+			for (int promoted : { Q, R, B, N })
+				move_list->push_back(encode_move(source_square, target_square, pawn, (promoted + pawn), 0, 0, 0, 0));
+		}
+
+		// captures
+		attacks = m_moves->getPawnAttacks(m_side, source_square) & enemies;
+		while (attacks) {
+			//Get target square
+			target_square = get_ls1b_index(attacks);
+
+			if (promotion) {
+				for (int promoted : { Q, R, B, N })
+					move_list->push_back(encode_move(source_square, target_square, pawn, (promoted + pawn), 1, 0, 0, 0));
+			}
+			else
+				move_list->push_back(encode_move(source_square, target_square, pawn, 0, 1, 0, 0, 0));
+
+			// pop ls1b index
+			pop_bit(attacks, target_square);
+		}
+
+		//Generate enpassant captures
+		if (m_enpassant != -1 && (m_moves->getPawnAttacks(m_side, source_square) & (1ULL << m_enpassant)))
+			move_list->push_back(encode_move(source_square, m_enpassant, pawn, 0, 1, 0, 1, 0));
+
+		// pop source square
+		pop_bit(bitboard, source_square);
+	}
+
+	// piece captures
+	for (uint8_t piece = pawn + 1; piece <= king; piece++)
+	{
+		// init piece bitboard copy
+		bitboard = m_bitboards[piece];
+
+		while (bitboard) {
+			// init source square
+			source_square = get_ls1b_index(bitboard);
+
+			// init attacks on enemy pieces
+			switch (piece - pawn) {
+			case N: attacks = m_moves->getKnightAttacks(source_square); break;
+			case B: attacks = m_moves->getBishopAttacks(source_square, m_occupancies[both]); break;
+			case R: attacks = m_moves->getRookAttacks(source_square, m_occupancies[both]); break;
+			case Q: attacks = m_moves->getQueenAttacks(source_square, m_occupancies[both]); break;
+			default: attacks = m_moves->getKingAttacks(source_square); break;
+			}
+			attacks &= enemies;
+
+			while (attacks) {
+				//Get target square
+				target_square = get_ls1b_index(attacks);
+				move_list->push_back(encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
+
+				// pop ls1b index
+				pop_bit(attacks, target_square);
 			}
+
+			// pop source square
+			pop_bit(bitboard, source_square);
+		}
+	}
+}
+
+bool Board::castlingAllowed(int target_square) const
+{
+	// right, squares between king and rook, squares the king passes
+	uint8_t right; uint64_t empty, safe;
+	switch (target_square) {
+	case (62): right = 1; empty = (1ULL << 61) | (1ULL << 62); safe = (1ULL << 60) | (1ULL << 61); break;
+	case (58): right = 2; empty = (1ULL << 57) | (1ULL << 58) | (1ULL << 59); safe = (1ULL << 60) | (1ULL << 59); break;
+	case (6): right = 4; empty = (1ULL << 5) | (1ULL << 6); safe = (1ULL << 4) | (1ULL << 5); break;
+	case (2): right = 8; empty = (1ULL << 1) | (1ULL << 2) | (1ULL << 3); safe = (1ULL << 3) | (1ULL << 4); break;
+	default: return false;
+	}
+
+	// castling of the side to move only
+	if (!(m_castle & right) || (m_side == white) != (target_square > 31))
+		return false;
+	if (m_occupancies[both] & empty)
+		return false;
+
+	while (safe) {
+		int square = get_ls1b_index(safe);
+		if (isSquareAttacked(square, m_side ^ 1))
+			return false;
+		pop_bit(safe, square);
+	}
+	return true;
+}
+
+void Board::generateQuiets(std::vector<uint64_t>* move_list) const
+{
+	HotRegion hot_region(hot_movegen);
+
+	// define source & target squares
+	uint8_t source_square, target_square;
+
+	// define current piece's bitboard copy & it's attacks
+	uint64_t bitboard, attacks;
+
+	// side dependent pieces & squares
+	uint8_t pawn = (m_side == white) ? P : p;
+	uint8_t king = (m_side == white) ? K : k;
+	int pawn_push = (m_side == white) ? -8 : 8;
+
+	// the rank a pawn promotes from & the one it double pushes from
+	uint64_t promotion_rank = (m_side == white) ? 0x000000000000FF00ULL : 0x00FF000000000000ULL;
+	uint64_t start_rank = (m_side == white) ? 0x00FF000000000000ULL : 0x000000000000FF00ULL;
+
+	// pawn pushes, promotions belong to the capture generator
+	bitboard = m_bitboards[pawn] & ~promotion_rank;
+	while (bitboard) {
+		// init source square
+		source_square = get_ls1b_index(bitboard);
+
+		target_square = source_square + pawn_push;
+		if (!get_bit(m_occupancies[both], target_square)) {
+			move_list->push_back(encode_move(source_square, target_square, pawn, 0, 0, 0, 0, 0));
+
+			if (get_bit(start_rank, source_square) && !get_bit(m_occupancies[both], target_square + pawn_push))
+				move_list->push_back(encode_move(source_square, (target_square + pawn_push), pawn, 0, 0, 1, 0, 0));
+		}
+
+		// pop source square
+		pop_bit(bitboard, source_square);
+	}
+
+	// castling
+	uint8_t king_square = (m_side == white) ? 60 : 4;
+	if (get_bit(m_bitboards[king], king_square)) {
+		for (int target : { king_square + 2, king_square - 2 })
+			if (castlingAllowed(target))
+				move_list->push_back(encode_move(king_square, target, king, 0, 0, 0, 0, 1));
+	}
+
+	// piece moves to empty squares
+	for (uint8_t piece = pawn + 1; piece <= king; piece++)
+	{
+		// init piece bitboard copy
+		bitboard = m_bitboards[piece];
+
+		while (bitboard) {
+			// init source square
+			source_square = get_ls1b_index(bitboard);
+
+			// init attacks on empty squares
+			switch (piece - pawn) {
+			case N: attacks = m_moves->getKnightAttacks(source_square); break;
+			case B: attacks = m_moves->getBishopAttacks(source_square, m_occupancies[both]); break;
+			case R: attacks = m_moves->getRookAttacks(source_square, m_occupancies[both]); break;
+			case Q: attacks = m_moves->getQueenAttacks(source_square, m_occupancies[both]); break;
+			default: attacks = m_moves->getKingAttacks(source_square); break;
+			}
+			attacks &= ~m_occupancies[both];
+
+			while (attacks) {
+				//Get target square
+				target_square = get_ls1b_index(attacks);
+				move_list->push_back(encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
+
+				// pop ls1b index
+				pop_bit(attacks, target_square);
+			}
+
+			// pop source square
+			pop_bit(bitboard, source_square);
 		}
 	}
 }
 
+int Board::decodeMove(int compact_move) const
+{
+	int source_square = compact_move & 0x3f;
+	int target_square = (compact_move >> 6) & 0x3f;
+	int promoted_piece = (compact_move >> 12) & 0xf;
+
+	int piece = pieceOn(source_square);
+	uint8_t pawn = (m_side == white) ? P : p;
+
+	// a piece of the side to move, not capturing its own pieces
+	if (piece < pawn || piece > pawn + K || get_bit(m_occupancies[m_side], target_square))
+		return 0;
+
+	int capture = get_bit(m_occupancies[m_side ^ 1], target_square) ? 1 : 0;
+
+	if (piece == pawn) {
+		int pawn_push = (m_side == white) ? -8 : 8;
+		bool last_rank = (m_side == white) ? target_square < 8 : target_square > 55;
+
+		// promotes to a piece of the side to move, always on the last rank
+		if (last_rank != (promoted_piece != 0))
+			return 0;
+		if (promoted_piece && (promoted_piece < pawn + N || promoted_piece > pawn + Q))
+			return 0;
+
+		// captures & enpassant
+		if (m_moves->getPawnAttacks(m_side, source_square) & (1ULL << target_square)) {
+			if (capture)
+				return encode_move(source_square, target_square, piece, promoted_piece, 1, 0, 0, 0);
+			if (target_square == m_enpassant)
+				return encode_move(source_square, target_square, piece, 0, 1, 0, 1, 0);
+			return 0;
+		}
+
+		// single push
+		if (get_bit(m_occupancies[both], target_square))
+			return 0;
+		if (target_square == source_square + pawn_push)
+			return encode_move(source_square, target_square, piece, promoted_piece, 0, 0, 0, 0);
+
+		// double push from the start rank
+		bool start_rank = (m_side == white) ? (source_square >= 48) : (source_square <= 15);
+		if (start_rank && target_square == source_square + 2 * pawn_push && !get_bit(m_occupancies[both], source_square + pawn_push))
+			return encode_move(source_square, target_square, piece, 0, 0, 1, 0, 0);
+		return 0;
+	}
+
+	if (promoted_piece)
+		return 0;
+
+	uint64_t attacks;
+	switch (piece - pawn) {
+	case N: attacks = m_moves->getKnightAttacks(source_square); break;
+	case B: attacks = m_moves->getBishopAttacks(source_square, m_occupancies[both]); break;
+	case R: attacks = m_moves->getRookAttacks(source_square, m_occupancies[both]); break;
+	case Q: attacks = m_moves->getQueenAttacks(source_square, m_occupancies[both]); break;
+	default:
+		// castling
+		if (source_square == ((m_side == white) ? 60 : 4) && (target_square == source_square + 2 || target_square == source_square - 2))
+			return castlingAllowed(target_square) ? encode_move(source_square, target_square, piece, 0, 0, 0, 0, 1) : 0;
+		attacks = m_moves->getKingAttacks(source_square);
+		break;
+	}
+
+	if (!get_bit(attacks, target_square))
+		return 0;
+	return encode_move(source_square, target_square, piece, 0, capture, 0, 0, 0);
+}
+
+int Board::pieceOn(int square) const
+{
+	uint8_t start_piece = get_bit(m_occupancies[white], square) ? P : p;
+	if (!get_bit(m_occupancies[both], square))
+		return -1;
+
+	for (int bb_piece = start_piece; bb_piece <= start_piece + K; bb_piece++)
+		if (get_bit(m_bitboards[bb_piece], square))
+			return bb_piece;
+	return -1;
+}
+
+bool Board::isRepetition() const {
+	// only the reversible plies can hold the same position, same side to move every other ply
+	int reversible = (m_fifty < m_plies_from_null) ? m_fifty : m_plies_from_null;
+	int size = (int)m_key_history.size();
+	if (reversible > size)
+		reversible = size;
+
+	for (int plies = 2; plies <= reversible; plies += 2)
+		if (m_key_history[size - plies] == m_hash_key)
+			return true;
+	return false;
+}
+
+void Board::makeNullMove() {
+	HotRegion hot_region(hot_make_unmake);
+
+	// repetitions don't reach across a null move
+	m_key_history.push_back(m_hash_key);
+	m_fifty++;
+	m_plies_from_null = 0;
+
+	// reset enpassant square
+	if (m_enpassant != -1)
+		m_hash_key ^= zobrist.enpassant[m_enpassant];
+	m_enpassant = -1;
+
+	// change side
+	m_side ^= 1;
+	m_hash_key ^= zobrist.side;
+}
+
 int Board::makeMove(int move, int move_flag){
+	HotRegion hot_region(hot_make_unmake);
+
 	// quite moves
 	if (move_flag == all_moves)
 	{
 		// preserve board state
 		copyBoard();
 
-		m_source_square = get_move_source(move);
-		m_target_square = get_move_target(move);
-		m_piece = get_move_piece(move);
-		m_promoted_piece = get_move_promoted(move);
-		m_capture = get_move_capture(move);
-		m_double_push = get_move_double(move);
-		m_enpass = get_move_enpassant(move);
-		m_castling = get_move_castling(move);
-		
+		// decode move
+		uint8_t source_square = get_move_source(move);
+		uint8_t target_square = get_move_target(move);
+		uint8_t piece = get_move_piece(move);
+		uint8_t promoted_piece = get_move_promoted(move);
+		int32_t capture = get_move_capture(move);
+		int32_t double_push = get_move_double(move);
+		int32_t enpass = get_move_enpassant(move);
+		int32_t castling = get_move_castling(move);
+
+		// piece square changes (piece * 64 + square) for the nnue accumulator
+		int added[2], removed[3];
+		int added_count = 0, removed_count = 0;
+
+		// position before the move, halfmove clock & move number
+		m_key_history.push_back(m_hash_key);
+		m_fifty = (capture || (piece % 6) == P) ? 0 : m_fifty + 1;
+		m_plies_from_null++;
+		if (m_side == black)
+			m_fullmove++;
 
 		// move piece
-		pop_bit(m_bitboards[m_piece], m_source_square);
-		set_bit(m_bitboards[m_piece], m_target_square);
+		pop_bit(m_bitboards[piece], source_square);
+		set_bit(m_bitboards[piece], target_square);
+		m_hash_key ^= zobrist.piece[piece][source_square] ^ zobrist.piece[piece][target_square];
+		removePieceScore(piece, source_square);
+		addPieceScore(piece, target_square);
+		removed[removed_count++] = piece * 64 + source_square;
+		added[added_count++] = piece * 64 + target_square;
+		if (piece % 6 == P)
+			m_pawn_key ^= zobrist.piece[piece][source_square] ^ zobrist.piece[piece][target_square];
 
 		//Get capture moves
-		if (m_capture) {
-			m_start_piece = ((m_side == white) ? p : P);
-			m_end_piece = ((m_side == white) ? k : K);
+		if (capture) {
+			uint8_t start_piece = ((m_side == white) ? p : P);
+			uint8_t end_piece = ((m_side == white) ? k : K);
 
-			for (int bb_piece = m_start_piece; bb_piece <= m_end_piece; bb_piece++) {
+			for (int bb_piece = start_piece; bb_piece <= end_piece; bb_piece++) {
 				// If a piece is found on target square
-				if (get_bit(m_bitboards[bb_piece], m_target_square)) {
-					pop_bit(m_bitboards[bb_piece], m_target_square);
+				if (get_bit(m_bitboards[bb_piece], target_square)) {
+					pop_bit(m_bitboards[bb_piece], target_square);
+					m_hash_key ^= zobrist.piece[bb_piece][target_square];
+					removePieceScore(bb_piece, target_square);
+					removed[removed_count++] = bb_piece * 64 + target_square;
+					removeMaterial(bb_piece);
+					if (bb_piece % 6 == P)
+						m_pawn_key ^= zobrist.piece[bb_piece][target_square];
 					break;
 				}
 			}
 		}
 
 		// handle pawn promotions
-		if (m_promoted_piece){
+		if (promoted_piece){
 			// erase the pawn from the target square
-			pop_bit(m_bitboards[(m_side == white) ? P : p], m_target_square);
+			pop_bit(m_bitboards[(m_side == white) ? P : p], target_square);
 
 			// set up promoted piece on chess board
-			set_bit(m_bitboards[m_promoted_piece], m_target_square);
+			set_bit(m_bitboards[promoted_piece], target_square);
+			m_hash_key ^= zobrist.piece[(m_side == white) ? P : p][target_square] ^ zobrist.piece[promoted_piece][target_square];
+			removePieceScore((m_side == white) ? P : p, target_square);
+			m_pawn_key ^= zobrist.piece[(m_side == white) ? P : p][target_square];
+			addPieceScore(promoted_piece, target_square);
+			// the pawn never arrives on the target square
+			added[added_count - 1] = promoted_piece * 64 + target_square;
+			removeMaterial((m_side == white) ? P : p);
+			addMaterial(promoted_piece);
 		}
 
 		// handle enpassant captures
-		if (m_enpass)
+		if (enpass)
 		{
 			// erase the pawn depending on side to move
-			(m_side == white) ? pop_bit(m_bitboards[p], m_target_square + 8) : pop_bit(m_bitboards[P], m_target_square - 8);
+			(m_side == white) ? pop_bit(m_bitboards[p], target_square + 8) : pop_bit(m_bitboards[P], target_square - 8);
+			m_hash_key ^= (m_side == white) ? zobrist.piece[p][target_square + 8] : zobrist.piece[P][target_square - 8];
+			(m_side == white) ? removePieceScore(p, target_square + 8) : removePieceScore(P, target_square - 8);
+			m_pawn_key ^= (m_side == white) ? zobrist.piece[p][target_square + 8] : zobrist.piece[P][target_square - 8];
+			removed[removed_count++] = (m_side == white) ? p * 64 + target_square + 8 : P * 64 + target_square - 8;
+			removeMaterial((m_side == white) ? p : P);
 		}
 		// reset enpassant square
+		if (m_enpassant != -1)
+			m_hash_key ^= zobrist.enpassant[m_enpassant];
 		m_enpassant = -1;
 
 		// handle double pawn push
-		if (m_double_push)
+		if (double_push)
 		{
 			// set enpassant aquare depending on side to move
-			(m_side == white) ? (m_enpassant = m_target_square + 8) : (m_enpassant = m_target_square - 8);
+			(m_side == white) ? (m_enpassant = target_square + 8) : (m_enpassant = target_square - 8);
+			m_hash_key ^= zobrist.enpassant[m_enpassant];
 		}
 
 		// handle castling moves
-		if (m_castling)
+		if (castling)
 		{
 			// switch target square
-			switch (m_target_square)
+			switch (target_square)
 			{
 				// white castles king side
 			case (62):
 				// move H rook
 				pop_bit(m_bitboards[R], 63);
 				set_bit(m_bitboards[R], 61);
+				m_hash_key ^= zobrist.piece[R][63] ^ zobrist.piece[R][61];
+				removePieceScore(R, 63);
+				addPieceScore(R, 61);
+				removed[removed_count++] = R * 64 + 63;
+				added[added_count++] = R * 64 + 61;
 				break;
 
 				// white castles queen side
@@ -806,6 +1513,11 @@ int Board::makeMove(int move, int move_flag){
 				// move A rook
 				pop_bit(m_bitboards[R], 56);
 				set_bit(m_bitboards[R], 59);
+				m_hash_key ^= zobrist.piece[R][56] ^ zobrist.piece[R][59];
+				removePieceScore(R, 56);
+				addPieceScore(R, 59);
+				removed[removed_count++] = R * 64 + 56;
+				added[added_count++] = R * 64 + 59;
 				break;
 
 				// black castles king side
@@ -813,6 +1525,11 @@ int Board::makeMove(int move, int move_flag){
 				// move H rook
 				pop_bit(m_bitboards[r], 7);
 				set_bit(m_bitboards[r], 5);
+				m_hash_key ^= zobrist.piece[r][7] ^ zobrist.piece[r][5];
+				removePieceScore(r, 7);
+				addPieceScore(r, 5);
+				removed[removed_count++] = r * 64 + 7;
+				added[added_count++] = r * 64 + 5;
 				break;
 
 				// black castles queen side
@@ -820,13 +1537,20 @@ int Board::makeMove(int move, int move_flag){
 				// move A rook
 				pop_bit(m_bitboards[r], 0);
 				set_bit(m_bitboards[r], 3);
+				m_hash_key ^= zobrist.piece[r][0] ^ zobrist.piece[r][3];
+				removePieceScore(r, 0);
+				addPieceScore(r, 3);
+				removed[removed_count++] = r * 64 + 0;
+				added[added_count++] = r * 64 + 3;
 				break;
 			}
 		}
 
 		// update castling rights
-		m_castle &= castling_rights[m_source_square];
-		m_castle &= castling_rights[m_target_square];
+		m_hash_key ^= zobrist.castle[m_castle];
+		m_castle &= castling_rights[source_square];
+		m_castle &= castling_rights[target_square];
+		m_hash_key ^= zobrist.castle[m_castle];
 
 		// reset occupancies
 		std::fill(m_occupancies.begin(), m_occupancies.end(), 0);
@@ -847,6 +1571,7 @@ int Board::makeMove(int move, int move_flag){
 
 		// change side
 		m_side ^= 1;
+		m_hash_key ^= zobrist.side;
 
 		// make sure that king has not been exposed into a check
 		if (isSquareAttacked((m_side == white) ? get_ls1b_index(m_bitboards[k]) : get_ls1b_index(m_bitboards[K]), m_side))
@@ -859,17 +1584,23 @@ int Board::makeMove(int move, int move_flag){
 		else
 			// return legal move
 			clearCopy();
-			return 1;
+
+		// accumulator of the new position from the previous one
+		if (m_network) {
+			m_accumulators.emplace_back();
+			m_network->update(m_accumulators[m_accumulators.size() - 2], m_accumulators.back(), added, added_count, removed, removed_count);
+		}
+		return 1;
 	}
 
 	// capture moves
 	else
 	{
-		// make sure move is the capture
-		if (get_move_capture(move))
-			makeMove(move, all_moves);
+		// make sure move is a capture (or a promotion)
+		if (get_move_capture(move) || get_move_promoted(move))
+			return makeMove(move, all_moves);
 
-		// otherwise the move is not a capture
+		// otherwise the move is quiet
 		else
 			// don't make it
 			return 0;
@@ -913,6 +1644,17 @@ void print_move_list(std::vector<uint64_t>* move_list)
 	std::cout << "\n\n    Total number of moves: " << move_list->size() << "\n\n";
 }
 
+std::string moveToString(int move)
+{
+	std::string str = square_to_coordinates[get_move_source(move)] + square_to_coordinates[get_move_target(move)];
+
+	// promoted piece in lower case
+	if (get_move_promoted(move))
+		str += (char)tolower(ascii_pieces[get_move_promoted(move)]);
+
+	return str;
+}
+
 //##################################################################################################################
 //                                                     TESTS
 //##################################################################################################################
@@ -1006,7 +1748,7 @@ void MoveGenerationTest() {
 	}
 
 	uint64_t t1 = get_time_ms();
-	std::cout << "Time to run : " << t1 - t0 << " microseconds" << std::endl;
+	std::cout << "Time to run : " << t1 - t0 << " milliseconds" << std::endl;
 
 }
 
@@ -1048,21 +1790,380 @@ void makeMoveTest() {
 
 }
 
-// leaf nodes (number of positions reached during the test of the move generator at a given depth)
-long nodes;
+// several threads query one shared read only position, results must match the single threaded ones
+void concurrentGenerationTest() {
+	Board board;
+	board.parse_fen(tricky_position);
+	const Board& shared = board;
+
+	// reference move list & attack maps
+	std::vector<uint64_t> expected_moves;
+	shared.generateMoves(&expected_moves);
+	uint64_t expected_attacks[2] = { 0ULL, 0ULL };
+	for (int side = white; side <= black; side++)
+		for (int square = 0; square < 64; square++)
+			if (shared.isSquareAttacked(square, side))
+				set_bit(expected_attacks[side], square);
+
+	std::atomic<int> mismatches(0);
+	std::vector<std::thread> workers;
+	for (int thread = 0; thread < 4; ++thread) {
+		workers.emplace_back([&]() {
+			std::vector<uint64_t> move_list;
+			move_list.reserve(max_moves);
+			for (int iteration = 0; iteration < 10000; ++iteration) {
+				move_list.clear();
+				shared.generateMoves(&move_list);
+				if (move_list != expected_moves)
+					mismatches++;
+
+				uint64_t attacks = 0ULL;
+				int side = iteration & 1;
+				for (int square = 0; square < 64; square++)
+					if (shared.isSquareAttacked(square, side))
+						set_bit(attacks, square);
+				if (attacks != expected_attacks[side])
+					mismatches++;
+			}
+		});
+	}
+	for (auto& worker : workers)
+		worker.join();
+
+	std::cout << "Concurrent generation mismatches : " << mismatches << std::endl;
+}
+
+// walk the move tree and compare the incremental hash key with a from scratch one
+static uint64_t hashKeyWalk(Board* b, int depth)
+{
+	uint32_t material_key;
+	int overflow;
+	b->generateMaterialKey(material_key, overflow);
+	uint64_t mismatches = (b->hashKey() != b->generateHashKey()) + (b->pawnKey() != b->generatePawnKey())
+		+ (b->materialKey() != material_key || b->materialOverflow() != overflow);
+	if (depth == 0)
+		return mismatches;
+
+	std::vector<uint64_t> move_list;
+	b->generateMoves(&move_list);
+	for (uint64_t move : move_list) {
+		b->copyBoard();
+		if (!b->makeMove(move, all_moves)) {
+			b->clearCopy();
+			continue;
+		}
+		mismatches += hashKeyWalk(b, depth - 1);
+		b->takeBack();
+	}
+	return mismatches;
+}
 
-// perft driver
-static inline void perftDriver(Board *b, int depth)
+// captures & promotions of the capture generator against the ones of the full generator
+static uint64_t captureWalk(Board* b, int depth)
 {
+	std::vector<uint64_t> move_list, captures, expected;
+	b->generateMoves(&move_list);
+	b->generateCaptures(&captures);
+	for (uint64_t move : move_list)
+		if (get_move_capture(move) || get_move_promoted(move))
+			expected.push_back(move);
+
+	std::sort(captures.begin(), captures.end());
+	std::sort(expected.begin(), expected.end());
+	uint64_t mismatches = (captures != expected);
+	if (depth == 0)
+		return mismatches;
+
+	for (uint64_t move : move_list) {
+		b->copyBoard();
+		if (!b->makeMove(move, all_moves)) {
+			b->clearCopy();
+			continue;
+		}
+		mismatches += captureWalk(b, depth - 1);
+		b->takeBack();
+	}
+	return mismatches;
+}
+
+void captureGenerationTest()
+{
+	Board b;
+	for (std::string fen : { start_position, tricky_position, killer_position, cmk_position }) {
+		b.parse_fen(fen);
+		std::cout << "Capture generation mismatches (" << fen << ") : " << captureWalk(&b, 3) << std::endl;
+	}
+}
+
+// make the move given in UCI notation, false if it is not a legal move
+static bool makeUciMove(Board* b, const std::string& uci)
+{
+	std::vector<uint64_t> move_list;
+	b->generateMoves(&move_list);
+	for (uint64_t move : move_list) {
+		if (moveToString((int)move) != uci)
+			continue;
+		b->copyBoard();
+		if (b->makeMove(move, all_moves))
+			return true;
+		b->clearCopy();
+	}
+	return false;
+}
+
+void repetitionTest()
+{
+	Board b;
+
+	// halfmove clock & move number from the FEN
+	b.parse_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 37 42 ");
+	b.plot();
+
+	// knights out & back: the start position repeats after 4 plies
+	b.parse_fen(start_position);
+	for (std::string move : { "g1f3", "g8f6", "f3g1", "f6g8" }) {
+		makeUciMove(&b, move);
+		std::cout << move << " : halfmove " << b.fifty() << " fullmove " << b.fullmove() << " repetition " << b.isRepetition() << std::endl;
+	}
+
+	// a pawn move makes the earlier positions unreachable
+	b.parse_fen(start_position);
+	for (std::string move : { "g1f3", "g8f6", "e2e4", "f6g8", "f3g1", "g8f6", "g1f3", "f6g8" }) {
+		makeUciMove(&b, move);
+		std::cout << move << " : halfmove " << b.fifty() << " fullmove " << b.fullmove() << " repetition " << b.isRepetition() << std::endl;
+	}
+
+	// take back restores the clocks & the history
+	for (int ply = 0; ply < 8; ply++)
+		b.takeBack();
+	std::cout << "Taken back : halfmove " << b.fifty() << " fullmove " << b.fullmove() << " key " << (b.hashKey() == b.generateHashKey()) << std::endl;
+}
+
+// captures + quiets against the full generator, decodeMove against every 16 bit move
+static uint64_t stagedWalk(Board* b, int depth)
+{
+	std::vector<uint64_t> move_list, staged;
+	b->generateMoves(&move_list);
+	b->generateCaptures(&staged);
+	b->generateQuiets(&staged);
+
+	std::sort(move_list.begin(), move_list.end());
+	std::sort(staged.begin(), staged.end());
+	uint64_t mismatches = (staged != move_list);
+
+	// a 16 bit move decodes to a move of the full generator, or to nothing
+	for (int compact_move = 0; compact_move < 0x10000; compact_move++) {
+		int move = b->decodeMove(compact_move);
+		bool generated = std::binary_search(move_list.begin(), move_list.end(), (uint64_t)move);
+		if (move ? !generated || compactMove(move) != compact_move : false)
+			mismatches++;
+	}
+	for (uint64_t move : move_list)
+		if (b->decodeMove(compactMove((int)move)) != (int)move)
+			mismatches++;
+
+	if (depth == 0)
+		return mismatches;
+
+	for (uint64_t move : move_list) {
+		b->copyBoard();
+		if (!b->makeMove(move, all_moves)) {
+			b->clearCopy();
+			continue;
+		}
+		mismatches += stagedWalk(b, depth - 1);
+		b->takeBack();
+	}
+	return mismatches;
+}
+
+void stagedGenerationTest()
+{
+	Board b;
+	for (std::string fen : { start_position, tricky_position, killer_position, cmk_position }) {
+		b.parse_fen(fen);
+		std::cout << "Staged generation mismatches (" << fen << ") : " << stagedWalk(&b, 2) << std::endl;
+	}
+}
+
+void hashKeyTest()
+{
+	Board b;
+	for (std::string fen : { start_position, tricky_position, killer_position, cmk_position }) {
+		b.parse_fen(fen);
+		std::cout << "Hash key mismatches (" << fen << ") : " << hashKeyWalk(&b, 3) << std::endl;
+	}
+}
+
+void fenTest()
+{
+	// fields written back as read
+	Board b, copy;
+	int round_trip_errors = 0;
+	for (const char* fen : { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 37 42",
+		"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+		"r2q1rk1/ppp2ppp/2n1bn2/2b1p3/3pP3/3P1NPP/PPP1NPB1/R1BQ1RK1 b - - 0 9",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1" }) {
+		if (b.parseFen(fen) != fen_ok || b.toFen() != fen) {
+			printf("  %s: %s, %s\n", fen, fenErrorString(b.parseFen(fen)), b.toFen().c_str());
+			round_trip_errors++;
+		}
+	}
+
+	// every position of random games: the FEN sets up the same position
+	std::vector<std::string> fens;
+	std::vector<uint64_t> move_list;
+	int walk_errors = 0;
+	srand(7);
+	for (int game = 0; game < 200; game++) {
+		b.parse_fen(start_position);
+		for (int ply = 0; ply < 200; ply++) {
+			std::string fen = b.toFen();
+			fens.push_back(fen);
+			if (copy.parseFen(fen) != fen_ok || copy.hashKey() != b.hashKey() || copy.pawnKey() != b.pawnKey() || copy.materialKey() != b.materialKey()
+				|| copy.scoreMg() != b.scoreMg() || copy.scoreEg() != b.scoreEg() || copy.phase() != b.phase() || copy.castle() != b.castle()
+				|| copy.enpassant() != b.enpassant() || copy.fifty() != b.fifty() || copy.fullmove() != b.fullmove() || copy.toFen() != fen)
+				walk_errors++;
+
+			move_list.clear();
+			b.generateMoves(&move_list);
+			std::vector<int> legal;
+			for (uint64_t move : move_list) {
+				b.copyBoard();
+				if (b.makeMove((int)move, all_moves)) {
+					legal.push_back((int)move);
+					b.takeBack();
+				}
+				else
+					b.clearCopy();
+			}
+			if (legal.empty())
+				break;
+			b.copyBoard();
+			b.makeMove(legal[rand() % legal.size()], all_moves);
+		}
+	}
+
+	// invalid FENs & their errors, the board is left as it was
+	const struct { const char* fen; FenError error; } invalid[] = {
+		{ "", fen_missing_field },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR", fen_missing_field },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq", fen_missing_field },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPX/RNBQKBNR w KQkq - 0 1", fen_bad_piece },
+		{ "rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", fen_bad_piece },
+		{ "rnbqkbnr/ppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", fen_bad_rank },
+		{ "rnbqkbnr/pppppppp/44/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", fen_bad_rank },
+		{ "rnbqkbnr/pppppppp/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", fen_bad_rank_count },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", fen_bad_rank_count },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1", fen_bad_side },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQxq - 0 1", fen_bad_castling },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w QK - 0 1", fen_bad_castling },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBN1 w KQkq - 0 1", fen_bad_castling },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e9 0 1", fen_bad_enpassant },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e3 0 1", fen_bad_enpassant },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e6 0 1", fen_bad_enpassant },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - x 1", fen_trailing_characters },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 99999 1", fen_bad_halfmove },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 0", fen_bad_fullmove },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0-1", fen_bad_halfmove },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 x", fen_trailing_characters },
+		{ "8/8/8/8/8/8/8/8 w - - 0 1", fen_bad_kings },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKKNR w kq - 0 1", fen_bad_kings },
+		{ "rnbqkbnP/pppppppp/8/8/8/8/PPPPPPP1/RNBQKBNR w KQq - 0 1", fen_bad_pawns },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 ", fen_ok },
+		{ "4k3/8/8/8/8/8/PPPPPPPPP/4K3 w - - 0 1", fen_bad_rank },
+		{ "4k3/8/8/8/8/8/PPPPPPPP/PPPPKPPP w - - 0 1", fen_bad_pawns },
+		{ "4k3/8/8/8/4Q3/8/8/4K3 w - - 0 1", fen_opponent_in_check },
+	};
+	int error_mismatches = 0;
+	b.parse_fen(start_position);
+	uint64_t start_key = b.hashKey();
+	for (const auto& test : invalid) {
+		FenError error = b.parseFen(test.fen);
+		if (error != test.error) {
+			printf("  %s: %s instead of %s\n", test.fen, fenErrorString(error), fenErrorString(test.error));
+			error_mismatches++;
+		}
+		if (error != fen_ok && b.hashKey() != start_key)
+			error_mismatches++;
+	}
+
+	// EPD: the operations are left to the caller
+	size_t length = 0;
+	std::string epd = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - bm e2a6; id \"kiwipete\";";
+	bool epd_ok = b.parseFen(epd, &length) == fen_ok && epd.compare(length, 4, " bm ") == 0;
+	epd = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0-1";
+	epd_ok &= b.parseFen(epd, &length) == fen_ok && length == epd.size() - 4 && b.fifty() == 0;
+	epd = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 3 1/2-1/2";
+	epd_ok &= b.parseFen(epd, &length) == fen_ok && length == epd.size() - 8 && b.fifty() == 3 && b.fullmove() == 1;
+
+	// lenient: the old test positions with K-kq load, their - is rejected by the strict parser only
+	std::string lenient = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/1R2K2R b K-kq - ";
+	bool lenient_ok = b.parse_fen(lenient) == fen_ok && b.castle() == 13 && b.side() == black
+		&& b.parseFen(lenient) == fen_bad_castling && b.parse_fen("8/8/8/8/8/8/8/8 x - - ") == fen_bad_side;
+
+	// throughput
+	const int repetitions = 20;
+	uint64_t start = get_time_ns();
+	int failures = 0;
+	for (int repetition = 0; repetition < repetitions; repetition++)
+		for (const std::string& fen : fens)
+			failures += b.parseFen(fen) != fen_ok;
+	double strict_ns = (double)(get_time_ns() - start);
+
+	start = get_time_ns();
+	for (int repetition = 0; repetition < repetitions; repetition++)
+		for (const std::string& fen : fens)
+			b.parse_fen(fen);
+	double lenient_ns = (double)(get_time_ns() - start);
+
+	char buffer[max_fen_length];
+	size_t characters = 0;
+	start = get_time_ns();
+	for (int repetition = 0; repetition < repetitions; repetition++)
+		for (const std::string& fen : fens) {
+			copy.parse_fen(fen);
+			characters += copy.writeFen(buffer);
+		}
+	double write_ns = (double)(get_time_ns() - start) - lenient_ns;
+
+	double count = (double)fens.size() * repetitions;
+	printf("\n     FEN parser\n\n");
+	printf("  round trip         %d errors\n", round_trip_errors);
+	printf("  game positions     %llu, %d errors\n", (unsigned long long)fens.size(), walk_errors);
+	printf("  invalid FENs       %d, %d mismatches\n", (int)(sizeof(invalid) / sizeof(invalid[0])), error_mismatches);
+	printf("  EPD operations     %s\n", epd_ok ? "left over" : "wrong");
+	printf("  lenient parse_fen  %s\n", lenient_ok ? "ok" : "wrong");
+	printf("  parseFen           %.0f ns, %.2f M FENs/s (%d failures)\n", strict_ns / count, count / strict_ns * 1e3, failures);
+	printf("  parse_fen          %.0f ns, %.2f M FENs/s\n", lenient_ns / count, count / lenient_ns * 1e3);
+	printf("  writeFen           %.0f ns, %.2f M FENs/s (%llu characters)\n\n", write_ns / count, count / write_ns * 1e3,
+		(unsigned long long)characters);
+}
+
+// perft driver, move_lists holds one preallocated list per remaining depth
+// nodes: leaf nodes (number of positions reached during the test of the move generator at a given depth)
+// returns true when time (polled every poll_interval leaves, by thread) stopped the walk
+static inline bool perftDriver(Board *b, int depth, std::vector<uint64_t>* move_lists, uint64_t& nodes, TimeManager* time, int thread)
+{
+	// the tree walk is a search hot region
+	HotRegion hot_region(hot_search);
+
 	// reccursion escape condition
 	if (depth == 0)
 	{
 		// increment nodes count (count reached positions)
 		nodes++;
-		return;
+
+		// poll the limits now and then
+		if (time && (nodes & (poll_interval - 1)) == 0)
+			return time->poll(thread, nodes);
+		return false;
 	}
 
-	std::vector<uint64_t>* move_list_ptr = new std::vector<uint64_t>();
+	// reuse the list of this depth
+	std::vector<uint64_t>* move_list_ptr = &move_lists[depth];
+	move_list_ptr->clear();
 
 	// generate moves
 	b->generateMoves(move_list_ptr);
@@ -1079,20 +2180,29 @@ static inline void perftDriver(Board *b, int depth)
 		}
 
 		// call perft driver recursively
-		perftDriver(b, depth - 1);
+		bool stopped = perftDriver(b, depth - 1, move_lists, nodes, time, thread);
 
 		// take back
 		b->takeBack();
+
+		if (stopped)
+			return true;
 	}
+	return false;
 }
 
-void perftTest(std::string fen_str, int depth)
+bool perftTest(std::string fen_str, int depth, TimeManager* time)
 {
 	printf("\n     Performance test\n\n");
 
 	Board *b_ptr = new Board();
 	// parse custom FEN string
-	b_ptr->parse_fen(fen_str);
+	FenError error = b_ptr->parse_fen(fen_str);
+	if (error != fen_ok) {
+		printf("    invalid fen (%s)\n", fenErrorString(error));
+		delete b_ptr;
+		return false;
+	}
 
 	std::vector<uint64_t>* move_list_ptr = new std::vector<uint64_t>();
 	// generate moves
@@ -1100,8 +2210,22 @@ void perftTest(std::string fen_str, int depth)
 	
 	print_move_list(move_list_ptr);
 
+	// move lists of every depth, allocated before entering the hot regions
+	std::vector<std::vector<uint64_t>> move_lists(depth + 1);
+	for (auto& list : move_lists)
+		list.reserve(max_moves);
+
+	resetHotRegionAllocations();
+
+	// leaf nodes
+	uint64_t nodes = 0;
+
+	// hardware counters, silently unavailable when perf_event_open is not permitted
+	PerfCounters counters;
+
 	// init start time
 	long start = get_time_ms();
+	counters.start();
 
 	// loop over generated moves
 	for (auto& move : (*move_list_ptr))
@@ -1117,16 +2241,21 @@ void perftTest(std::string fen_str, int depth)
 		}
 
 		// cummulative nodes
-		long cummulative_nodes = nodes;
+		uint64_t cummulative_nodes = nodes;
 
 		// call perft driver recursively
-		perftDriver(b_ptr, depth - 1);
+		bool stopped = perftDriver(b_ptr, depth - 1, move_lists.data(), nodes, time, 0);
 
 		// old nodes
-		long old_nodes = nodes - cummulative_nodes;
+		uint64_t old_nodes = nodes - cummulative_nodes;
 
 		// take back
 		b_ptr->takeBack();
+
+		if (stopped) {
+			printf("\n    Stopped after %llu ms\n", (unsigned long long)time->elapsedMs());
+			break;
+		}
 		
 		// print move
 		std::cout << square_to_coordinates[get_move_source(move)];
@@ -1136,10 +2265,103 @@ void perftTest(std::string fen_str, int depth)
 		std::cout << old_nodes << std::endl;
 	}
 
+	counters.disable();
+	long elapsed = get_time_ms() - start;
+
 	// print results
 	printf("\n    Depth: %d\n", depth);
-	printf("    Nodes: %ld\n", nodes);
-	printf("     Time: %ld\n\n", get_time_ms() - start);
+	printf("    Nodes: %llu\n", (unsigned long long)nodes);
+	printf("     Time: %ld\n\n", elapsed);
+
+	// print hardware counters for the run & per node
+	printPerfSample(counters.read(), nodes, "node");
+	printf("\n");
 
 	std::cout << "Stack size : " << b_ptr->stackSize() << std::endl;
+
+	// fail on heap allocations in movegen, make/unmake or the tree walk
+	return checkHotRegions("perft");
+}
+
+// perft on several threads: the first plies are split into tasks that the workers pick up one by one
+uint64_t perftParallel(std::string fen_str, int depth, int threads, TimeManager* time)
+{
+	if (depth <= 0)
+		return 1;
+
+	Board root;
+	FenError error = root.parse_fen(fen_str);
+	if (error != fen_ok) {
+		printf("    invalid fen (%s)\n", fenErrorString(error));
+		return 0;
+	}
+
+	// tasks are the legal move sequences of the first split_depth plies
+	int split_depth = (depth >= 3) ? 2 : 1;
+	std::vector<std::vector<uint64_t>> tasks = { {} };
+	for (int ply = 0; ply < split_depth; ++ply) {
+		std::vector<std::vector<uint64_t>> next_tasks;
+		for (const auto& task : tasks) {
+			for (uint64_t move : task)
+				root.makeMove(move, all_moves);
+
+			std::vector<uint64_t> move_list;
+			root.generateMoves(&move_list);
+			for (uint64_t move : move_list) {
+				root.copyBoard();
+				if (root.makeMove(move, all_moves)) {
+					next_tasks.push_back(task);
+					next_tasks.back().push_back(move);
+					root.takeBack();
+				}
+				else
+					root.clearCopy();
+			}
+
+			// back to the root position
+			root.parse_fen(fen_str);
+		}
+		tasks.swap(next_tasks);
+	}
+
+	// leaf nodes of every thread
+	std::vector<uint64_t> thread_nodes(threads, 0);
+	if (time)
+		time->setThreads(threads);
+	std::atomic<size_t> next_task(0);
+
+	std::vector<std::thread> workers;
+	for (int thread = 0; thread < threads; ++thread) {
+		workers.emplace_back([&, thread]() {
+			// own board & move lists per thread
+			Board board = root;
+			std::vector<std::vector<uint64_t>> move_lists(depth + 1);
+			for (auto& list : move_lists)
+				list.reserve(max_moves);
+
+			uint64_t nodes = 0;
+			for (size_t index = next_task++; index < tasks.size(); index = next_task++) {
+				for (uint64_t move : tasks[index]) {
+					board.copyBoard();
+					board.makeMove(move, all_moves);
+				}
+
+				bool stopped = perftDriver(&board, depth - split_depth, move_lists.data(), nodes, time, thread);
+
+				for (size_t ply = 0; ply < tasks[index].size(); ++ply)
+					board.takeBack();
+
+				if (stopped)
+					break;
+			}
+			thread_nodes[thread] = nodes;
+		});
+	}
+
+	uint64_t nodes = 0;
+	for (int thread = 0; thread < threads; ++thread) {
+		workers[thread].join();
+		nodes += thread_nodes[thread];
+	}
+	return nodes;
 }
\ No newline at end of file
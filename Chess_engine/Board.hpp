@@ -4,72 +4,233 @@
 #include <iostream>
 #include "Utility.hpp"
 #include "Moves.hpp"
+#include "AllocTracker.hpp"
+#include "Nnue.hpp"
 #include <stack>
 #include <array>
+#include <string>
+#include <string_view>
+
+
+// encode pieces
+enum { P, N, B, R, Q, K, p, n, b, r, q, k };
+
+// sides to move (colors)
+enum { white, black, both };
+
+// bishop and rook
+enum { rook, bishop };
+
+/*
+		  binary move bits                               hexidecimal constants
+
+	0000 0000 0000 0000 0011 1111    source square       0x3f
+	0000 0000 0000 1111 1100 0000    target square       0xfc0
+	0000 0000 1111 0000 0000 0000    piece               0xf000
+	0000 1111 0000 0000 0000 0000    promoted piece      0xf0000
+	0001 0000 0000 0000 0000 0000    capture flag        0x100000
+	0010 0000 0000 0000 0000 0000    double push flag    0x200000
+	0100 0000 0000 0000 0000 0000    enpassant flag      0x400000
+	1000 0000 0000 0000 0000 0000    castling flag       0x800000
+*/
+
+// encode move
+#define encode_move(source, target, piece, promoted, capture, double, enpassant, castling) \
+    (source) |          \
+    (target << 6) |     \
+    (piece << 12) |     \
+    (promoted << 16) |  \
+    (capture << 20) |   \
+    (double << 21) |    \
+    (enpassant << 22) | \
+    (castling << 23)    \
+
+// extract source square
+#define get_move_source(move) (move & 0x3f)
+
+// extract target square
+#define get_move_target(move) ((move & 0xfc0) >> 6)
+
+// extract piece
+#define get_move_piece(move) ((move & 0xf000) >> 12)
+
+// extract promoted piece
+#define get_move_promoted(move) ((move & 0xf0000) >> 16)
+
+// extract capture flag
+#define get_move_capture(move) (move & 0x100000)
+// ((move >> 20) & 0b1)
+
+// extract double pawn push flag
+#define get_move_double(move) (move & 0x200000)
+
+// extract enpassant flag
+#define get_move_enpassant(move) (move & 0x400000)
+
+// extract castling flag
+#define get_move_castling(move) (move & 0x800000)
+
+// move types
+enum { all_moves, only_captures };
+
+// result of parseFen: fen_ok or the first problem found
+enum FenError {
+	fen_ok, fen_missing_field, fen_bad_piece, fen_bad_rank, fen_bad_rank_count, fen_bad_side, fen_bad_castling,
+	fen_bad_enpassant, fen_bad_halfmove, fen_bad_fullmove, fen_bad_kings, fen_bad_pawns, fen_too_many_pieces,
+	fen_opponent_in_check, fen_trailing_characters
+};
+
+// longest FEN written by writeFen, terminating zero included
+const int max_fen_length = 96;
+
+// copies kept by copyBoard before the stack has to grow (and allocate)
+const int max_copy_stack = 1024;
+
+// move list capacity, more than the pseudo legal moves of any position
+const int max_moves = 256;
 
 
 class Board {
 
 	struct boardStruct {
-		std::vector<uint64_t> m_bitboards;
-		std::vector<uint64_t> m_occupancies;
+		std::array<uint64_t, 12> m_bitboards;
+		std::array<uint64_t, 3> m_occupancies;
 		int16_t m_side;
 		int16_t m_enpassant;
 		int8_t m_castle;
+		int16_t m_fifty;
+		int16_t m_fullmove;
+		int16_t m_plies_from_null;
+		uint32_t m_history_size;
+		uint32_t m_accumulator_size;
+		uint64_t m_hash_key;
+		uint64_t m_pawn_key;
+		uint32_t m_material_key;
+		int8_t m_material_overflow;
+		int16_t m_score_mg;
+		int16_t m_score_eg;
+		int16_t m_phase;
 	};
 
 	//Board init
-	std::vector<uint64_t> m_bitboards;
-	std::vector<uint64_t> m_occupancies = std::vector<uint64_t>(3);
+	std::array<uint64_t, 12> m_bitboards = {};
+	std::array<uint64_t, 3> m_occupancies = {};
 	int8_t m_side = -1;
 	int8_t m_enpassant = -1;
 	int8_t m_castle = 0;
+	// halfmove clock (plies since the last capture or pawn move) & move number
+	int16_t m_fifty = 0;
+	int16_t m_fullmove = 1;
+	// plies since the last null move, repetitions can't reach across it
+	int16_t m_plies_from_null = 0;
+	// zobrist key, updated incrementally by makeMove
+	uint64_t m_hash_key = 0ULL;
+	// zobrist key of the pawns only (pawn hash table), updated incrementally by makeMove
+	uint64_t m_pawn_key = 0ULL;
+	// piece counts (material table index) & the number of pieces beyond the counts it can hold, updated by makeMove
+	uint32_t m_material_key = 0;
+	int8_t m_material_overflow = 0;
+	// material + piece square scores (white point of view) & game phase, updated incrementally by makeMove
+	int16_t m_score_mg = 0;
+	int16_t m_score_eg = 0;
+	int16_t m_phase = 0;
 	boardStruct m_state;
-	Moves m_moves;
+	// attack tables, shared by every board
+	const Moves* m_moves = &sharedMoves();
 
-	boardStruct m_bs;
-	std::stack<boardStruct> m_copy_stack = {};
+	// stacks reserved up front (and on board copies) so copyBoard & makeMove never allocate. A stack that isn't
+	// reserved up front is reserved on demand, its copies only when it has been
+	template <typename T, bool up_front = true>
+	struct reservedStack : std::vector<T> {
+		reservedStack() { if (up_front) this->reserve(max_copy_stack); }
+		reservedStack(const reservedStack& other) : reservedStack() { *this = other; }
+		reservedStack& operator=(const reservedStack& other) {
+			if (other.capacity() >= max_copy_stack)
+				this->reserve(max_copy_stack);
+			this->assign(other.begin(), other.end());
+			return *this;
+		}
+	};
+	reservedStack<boardStruct> m_copy_stack;
+
+	// keys of the positions before every move made since parse_fen
+	reservedStack<uint64_t> m_key_history;
 
-	// Move generation variables
-	// define source & target squares
-	uint8_t m_source_square;
-	uint8_t m_target_square;
+	// NNUE network (optional) & the accumulators of the positions made since parse_fen, updated incrementally by makeMove,
+	// reserved by setNetwork (1 KB each, nothing without a network)
+	const NnueNetwork* m_network = nullptr;
+	reservedStack<NnueAccumulator, false> m_accumulators;
 
-	// define current piece's bitboard copy & it's attacks
-	uint64_t m_bitboard, m_attacks;
+	// accumulator of the current position from scratch, replacing the stack
+	void refreshAccumulator();
 
-	// makeMove variables
-	uint8_t m_piece = 0;
-	uint8_t m_promoted_piece = 0;
-	int32_t m_capture = 0;
-	int32_t m_double_push = 0;
-	int32_t m_enpass = 0;
-	int32_t m_castling = 0;
+	// add or remove the scores & phase of piece on square
+	void addPieceScore(int piece, int square);
+	void removePieceScore(int piece, int square);
 
-	uint8_t m_start_piece = 0;
-	uint8_t m_end_piece = 0;
+	// parse the fields of fen (see parseFen), validate: check the syntax strictly & the position as well
+	FenError setFen(std::string_view fen, bool validate, size_t* length);
+
+	// material key & overflow after a piece was added to or removed from its bitboard
+	void addMaterial(int piece);
+	void removeMaterial(int piece);
 
 
 public:
 
-	Board() {
-		for (int i = 0; i < 12; ++i) {
-			m_bitboards.push_back(0);
-		}
-		m_moves.initAll();
-	}
+	Board() {}
+
+	std::array<uint64_t, 12>  const& bitboards() const { return m_bitboards; }
+	std::array<uint64_t, 3>  const& occupancies() const { return m_occupancies; }
+	int16_t side() const { return m_side; }
+	int16_t enpassant() const { return m_enpassant; }
+	int16_t castle() const { return m_castle; }
+	int16_t stackSize() const { return m_copy_stack.size(); }
+	uint64_t hashKey() const { return m_hash_key; }
+	uint64_t pawnKey() const { return m_pawn_key; }
+	uint32_t materialKey() const { return m_material_key; }
+	int8_t materialOverflow() const { return m_material_overflow; }
+	int16_t fifty() const { return m_fifty; }
+	int16_t fullmove() const { return m_fullmove; }
+	int16_t scoreMg() const { return m_score_mg; }
+	int16_t scoreEg() const { return m_score_eg; }
+	int16_t phase() const { return m_phase; }
+	const NnueNetwork* network() const { return m_network; }
+	const NnueAccumulator& accumulator() const { return m_accumulators.back(); }
 
-	std::vector<uint64_t>  const& bitboards() { return m_bitboards; }
-	int16_t side() { return m_side; }
-	int16_t enpassant() { return m_enpassant; }
-	int16_t castle() { return m_castle; }
-	int16_t stackSize() { return m_copy_stack.size(); }
+	// evaluate with network from now on (nullptr: handcrafted evaluation), the network must outlive the board
+	void setNetwork(const NnueNetwork* network);
+
+	// network score from the side to move point of view
+	int nnueEvaluate() const { return m_network->evaluate(m_accumulators.back(), m_side); }
 
 	void add_piece(uint32_t piece_val, uint32_t file, uint32_t rank);
 
-	void parse_fen(std::string fen);
+	// lenient: syntax errors leave the board unchanged & are returned, the position itself isn't checked
+	FenError parse_fen(std::string_view fen);
+
+	// strict: the position is set up only when the fields & the position are valid. Without length anything after
+	// the FEN is an error, with length the characters parsed are returned & the rest (EPD operations) is left over
+	FenError parseFen(std::string_view fen, size_t* length = nullptr);
+
+	// FEN of the position (all six fields) into fen (max_fen_length characters), returns its length without the zero
+	int writeFen(char* fen) const;
+
+	std::string toFen() const;
+
+	// zobrist key computed from scratch
+	uint64_t generateHashKey() const;
+
+	// pawn key computed from scratch
+	uint64_t generatePawnKey() const;
+
+	// material key & overflow computed from scratch
+	void generateMaterialKey(uint32_t& key, int& overflow) const;
 
-	std::vector<uint64_t>  getOccupationBoard();
+	// midgame & endgame scores and game phase computed from scratch
+	void generateScores(int& score_mg, int& score_eg, int& phase) const;
+
+	std::array<uint64_t, 3>  getOccupationBoard();
 
 	void plot();
 
@@ -79,16 +240,51 @@ public:
 
 	void clearCopy();
 
-	bool isSquareAttacked(int square, int side);
+	// read only, safe to call from several threads on the same board
+	bool isSquareAttacked(int square, int side) const;
+
+	// pieces of both sides attacking square with the given occupancy (x-rays appear as the occupancy shrinks)
+	uint64_t attackersTo(int square, uint64_t occupancy) const;
+
+	// side to move king is attacked
+	bool inCheck() const;
+
+	// generate all moves (read only, the scratch state lives on the stack)
+	void generateMoves(std::vector<uint64_t>* move_list) const;
+
+	// generate captures, enpassant & promotions only (quiescence search)
+	void generateCaptures(std::vector<uint64_t>* move_list) const;
+
+	// generate quiet moves only (no captures, no promotions), with generateCaptures all the moves
+	void generateQuiets(std::vector<uint64_t>* move_list) const;
 
-	// generate all moves
-	void generateMoves(std::vector<uint64_t>* move_list);
+	// the pseudo legal move matching a 16 bit move (source | target << 6 | promoted << 12), 0 if there is none
+	int decodeMove(int compact_move) const;
 
+	// castling of the side to move to target square is possible now
+	bool castlingAllowed(int target_square) const;
+
+	// piece on square, -1 if empty
+	int pieceOn(int square) const;
+
+	// the position occurred before, within the reversible plies (since the last capture, pawn move or null move)
+	bool isRepetition() const;
+
+	// pass the move to the other side (null move pruning), preserve the board with copyBoard first
+	void makeNullMove();
+
+	// all_moves: make any move, only_captures: make captures & promotions only (returns 0 for quiet moves)
 	int makeMove(int move, int move_flag);
 };
 
 void print_move_list(std::vector<uint64_t>* move_list);
 
+// move in UCI notation (e7e8q)
+std::string moveToString(int move);
+
+// description of a parseFen result
+const char* fenErrorString(int error);
+
 void boardTest();
 
 void isAttackedTest();
@@ -99,6 +295,22 @@ void copyTakeBackTest();
 
 void makeMoveTest();
 
-static inline void perftDriver(Board *b, int depth);
+void concurrentGenerationTest();
+
+void hashKeyTest();
+
+// round trips, error codes & FENs per second
+void fenTest();
+
+void captureGenerationTest();
+
+void repetitionTest();
+
+void stagedGenerationTest();
+
+class TimeManager;
+
+// perft, stopped early by the limits of time (optional, started by the caller)
+bool perftTest(std::string fen_str, int depth, TimeManager* time = nullptr);
 
-void perftTest(std::string fen_str, int depth);
\ No newline at end of file
+uint64_t perftParallel(std::string fen_str, int depth, int threads, TimeManager* time = nullptr);
\ No newline at end of file
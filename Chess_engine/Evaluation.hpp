@@ -0,0 +1,38 @@
+#pragma once
+#include "Board.hpp"
+#include "Pawns.hpp"
+#include "AttackMaps.hpp"
+#include "Material.hpp"
+
+// Debug builds compare the incremental scores with a from scratch computation on every evaluation,
+// define EVAL_INCREMENTAL_CHECK to enable it in any other build.
+#if defined(_DEBUG) && !defined(EVAL_INCREMENTAL_CHECK)
+#define EVAL_INCREMENTAL_CHECK
+#endif
+
+// material values [piece]
+const int material_score[12] = {
+	100, 320, 330, 500, 900, 0,
+	-100, -320, -330, -500, -900, 0
+};
+
+// game phase of each piece, the starting material adds up to max_phase (midgame) and bare kings to 0 (endgame)
+const int phase_increment[12] = { 0, 1, 1, 2, 4, 0, 0, 1, 1, 2, 4, 0 };
+const int max_phase = 24;
+
+// midgame & endgame material + piece square scores [piece][square], white positive & black negative
+struct pieceSquareTables {
+	int mg[12][64];
+	int eg[12][64];
+};
+
+extern const pieceSquareTables pst;
+
+// tapered score (white point of view) of the midgame & endgame scores at the given phase
+int taperedScore(int score_mg, int score_eg, int phase);
+
+// static evaluation from the side to move point of view, pawn structure cached in pawn_table (optional),
+// the attack maps of the position are built into attacks (optional) for move ordering
+int evaluate(const Board& board, PawnTable* pawn_table = nullptr, AttackMaps* attacks = nullptr);
+
+void evaluationTest();
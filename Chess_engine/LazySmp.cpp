@@ -0,0 +1,151 @@
+#include "LazySmp.hpp"
+#include "Scaling.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <thread>
+
+//##################################################################################################################
+//                                                     LAZY SMP METHODS
+//##################################################################################################################
+
+LazySmp::LazySmp(TranspositionTable* tt, int threads) : m_tt(tt) {
+	setThreads(threads);
+}
+
+void LazySmp::setThreads(int threads) {
+	m_searches.clear();
+	for (int id = 0; id < (threads > 0 ? threads : 1); ++id) {
+		m_searches.emplace_back(new Search());
+		m_searches.back()->setThreadId(id);
+		m_searches.back()->setTimeManager(&m_time);
+		m_searches.back()->setCoordinated(true);
+		m_searches.back()->setTranspositionTable(m_tt);
+		m_searches.back()->setTablebases(m_tablebases);
+	}
+
+	// the main thread reports the nodes of all threads
+	m_searches.front()->setNodeReporter([this]() { return nodes(); });
+	m_time.setThreads(threads);
+}
+
+void LazySmp::setTablebases(const Tablebases* tablebases) {
+	m_tablebases = tablebases;
+	for (auto& search : m_searches)
+		search->setTablebases(tablebases);
+}
+
+uint64_t LazySmp::nodes() const {
+	uint64_t total = 0;
+	for (const auto& search : m_searches)
+		total += search->nodes();
+	return total;
+}
+
+int LazySmp::voteBestThread() const {
+	int min_score = infinity;
+	for (const auto& search : m_searches)
+		if (search->lastResult().best_move && search->lastResult().score < min_score)
+			min_score = search->lastResult().score;
+
+	// a thread votes for its move with its score above the worst one, weighted by its depth
+	std::map<int, int64_t> votes;
+	for (const auto& search : m_searches) {
+		const SearchResult& result = search->lastResult();
+		if (result.best_move)
+			votes[result.best_move] += (int64_t)(result.score - min_score + 14) * result.depth;
+	}
+
+	int best_thread = 0;
+	for (int id = 1; id < (int)m_searches.size(); ++id) {
+		const SearchResult& best = m_searches[best_thread]->lastResult();
+		const SearchResult& result = m_searches[id]->lastResult();
+		if (!result.best_move)
+			continue;
+
+		// a found mate wins, otherwise the most voted move (deeper thread on equal votes)
+		if (result.score > mate_score && result.score > best.score)
+			best_thread = id;
+		else if (best.score <= mate_score && (!best.best_move || votes[result.best_move] > votes[best.best_move]
+			|| (votes[result.best_move] == votes[best.best_move] && result.depth > best.depth)))
+			best_thread = id;
+	}
+	return best_thread;
+}
+
+SearchResult LazySmp::search(const Board& board, int max_depth, bool verbose) {
+	SearchLimits limits;
+	limits.depth = max_depth;
+	return search(board, limits, verbose);
+}
+
+SearchResult LazySmp::search(const Board& board, const SearchLimits& limits, bool verbose) {
+	m_time.start(limits, board.side());
+	m_searching.store(true, std::memory_order_release);
+	int max_depth = limits.depth ? limits.depth : max_ply - 1;
+
+	for (auto& search : m_searches)
+		search->setPosition(board);
+
+	// age the table before any thread stores
+	if (m_tt)
+		m_tt->newSearch();
+
+	std::vector<std::thread> helpers;
+	for (int id = 1; id < (int)m_searches.size(); ++id)
+		helpers.emplace_back([this, id, max_depth]() { m_searches[id]->searchPosition(max_depth, false); });
+
+	m_searches.front()->searchPosition(max_depth, verbose);
+
+	// an infinite or ponder search reports its move only once stopped (or the ponder move is played)
+	while ((limits.infinite || m_time.pondering()) && !m_time.stopped())
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	// the main thread is done, the helpers stop as well
+	stop();
+	for (auto& helper : helpers)
+		helper.join();
+	m_searching.store(false, std::memory_order_release);
+
+	SearchResult result = m_searches[voteBestThread()]->lastResult();
+	result.nodes = nodes();
+	result.time_ms = m_searches.front()->lastResult().time_ms;
+
+	if (verbose && result.best_move)
+		printf("bestmove %s\n", moveToString(result.best_move).c_str());
+
+	return result;
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+void smpScalingTest(std::string fen_str, int depth, int max_threads, std::string json_path) {
+	if (max_threads <= 0)
+		max_threads = 64;
+
+	Board board;
+	board.parse_fen(fen_str);
+	TranspositionTable tt(16);
+
+	printf("\n     Lazy SMP scaling: search depth %d, 1 to %d threads (%u hardware threads)\n", depth, max_threads,
+		std::thread::hardware_concurrency());
+
+	// time to depth from an empty table, the nodes of all threads give nodes per second
+	std::vector<ScalingPoint> points = runScaling([&](int threads) {
+		tt.clear();
+		LazySmp smp(&tt, threads);
+		SearchResult result = smp.search(board, depth, false);
+		printf("    %2d threads: bestmove %s %s depth %d\n", threads, moveToString(result.best_move).c_str(),
+			scoreToString(result.score).c_str(), result.depth);
+		return result.nodes;
+	}, max_threads, 1);
+	printScaling(points);
+
+	if (writeScalingJson(points, "lazy smp depth " + std::to_string(depth) + " " + fen_str, json_path))
+		std::cout << "Results written to " << json_path << std::endl;
+	else
+		std::cout << "Could not write " << json_path << std::endl;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "Search.hpp"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+		Lazy SMP
+
+	Every thread runs its own iterative deepening on its own Board copy with its
+	own history tables. The threads only share the lock free transposition table:
+	helpers skip some depths and order quiet moves slightly differently, so they
+	fill the table with results the main thread then finds. The main thread's
+	search decides when to stop, the best move is voted by all threads.
+*/
+
+class LazySmp {
+
+	TranspositionTable* m_tt = nullptr;
+
+	// endgame tables of all threads (optional)
+	const Tablebases* m_tablebases = nullptr;
+
+	// one search per thread, thread 0 is the main thread
+	std::vector<std::unique_ptr<Search>> m_searches;
+
+	// limits & stop signal of all threads
+	TimeManager m_time;
+
+	// between the start of the clock & the end of the threads
+	std::atomic<bool> m_searching{ false };
+
+	// thread with the most votes for its move
+	int voteBestThread() const;
+
+public:
+
+	LazySmp(TranspositionTable* tt, int threads = 1);
+
+	LazySmp(const LazySmp&) = delete;
+	LazySmp& operator=(const LazySmp&) = delete;
+
+	void setThreads(int threads);
+
+	void setTablebases(const Tablebases* tablebases);
+
+	int threads() const { return (int)m_searches.size(); }
+
+	// search the position within the limits on all threads, prints the main thread info lines when verbose
+	SearchResult search(const Board& board, const SearchLimits& limits, bool verbose = true);
+
+	// search the position to max_depth
+	SearchResult search(const Board& board, int max_depth, bool verbose = true);
+
+	// nodes of all threads
+	uint64_t nodes() const;
+
+	// stop all threads, callable from any thread
+	void stop() { m_time.stop(); }
+
+	// the ponder move was played, the limits of the search apply from now on (callable from any thread)
+	void ponderhit() { m_time.ponderhit(); }
+
+	// the clock of a search has started & its threads still run, stop() & ponderhit() reach it
+	bool searching() const { return m_searching.load(std::memory_order_acquire); }
+};
+
+// time to depth & nodes per second at 1, 2, 4, ... threads
+void smpScalingTest(std::string fen_str, int depth, int max_threads, std::string json_path);
@@ -0,0 +1,234 @@
+#include "Material.hpp"
+#include "Evaluation.hpp"
+#include "Bitbase.hpp"
+#include "Utility.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+//##################################################################################################################
+//                                                     VARIABLES
+//##################################################################################################################
+
+// bishop pair, knights gain & rooks lose value with every own pawn beyond five
+const int bishop_pair_mg = 30, bishop_pair_eg = 50;
+const int knight_pawn_bonus = 6;
+const int rook_pawn_bonus = -12;
+
+// won endgames score above any material balance of the normal evaluation
+const int known_win = 1000;
+
+// scale factors
+const int scale_opposite = 32;
+const int scale_pawnless = 16;
+
+// non king pieces of each kind [piece], either from the bitboards or decoded from a material key
+struct materialCounts {
+	int count[12];
+	int pawns(int side) const { return count[side * 6 + P]; }
+	int knights(int side) const { return count[side * 6 + N]; }
+	int bishops(int side) const { return count[side * 6 + B]; }
+	int rooks(int side) const { return count[side * 6 + R]; }
+	int queens(int side) const { return count[side * 6 + Q]; }
+	int pieces(int side) const { return knights(side) + bishops(side) + rooks(side) + queens(side); }
+	int pieceMaterial(int side) const {
+		return knights(side) * material_score[N] + bishops(side) * material_score[B] + rooks(side) * material_score[R] + queens(side) * material_score[Q];
+	}
+	// enough to force mate against a bare king
+	bool canMate(int side) const {
+		return pawns(side) || rooks(side) || queens(side) || bishops(side) >= 2 || (bishops(side) && knights(side)) || knights(side) >= 3;
+	}
+};
+
+// everything the material alone tells
+static MaterialEntry computeEntry(const materialCounts& counts)
+{
+	MaterialEntry entry = {};
+
+	int imbalance_mg = 0, imbalance_eg = 0;
+	for (int side = white; side <= black; side++) {
+		int sign = (side == white) ? 1 : -1;
+		int extra_pawns = counts.pawns(side) - 5;
+		if (counts.bishops(side) >= 2) {
+			imbalance_mg += sign * bishop_pair_mg;
+			imbalance_eg += sign * bishop_pair_eg;
+		}
+		int adjustment = counts.knights(side) * knight_pawn_bonus * extra_pawns + counts.rooks(side) * rook_pawn_bonus * extra_pawns;
+		imbalance_mg += sign * adjustment;
+		imbalance_eg += sign * adjustment;
+	}
+	entry.imbalance_mg = (int16_t)imbalance_mg;
+	entry.imbalance_eg = (int16_t)imbalance_eg;
+
+	// endgames with their own evaluation
+	int total_pawns = counts.pawns(white) + counts.pawns(black);
+	if (!total_pawns && !counts.canMate(white) && !counts.canMate(black))
+		entry.endgame = endgame_draw;
+	else if (!total_pawns && (!counts.pieces(white) || !counts.pieces(black))) {
+		int strong = counts.pieces(white) ? white : black;
+		bool bishop_knight = counts.pieces(strong) == 2 && counts.bishops(strong) == 1 && counts.knights(strong) == 1;
+		entry.endgame = bishop_knight ? endgame_kbnk : endgame_kxk;
+	}
+	else if (total_pawns == 1 && !counts.pieces(white) && !counts.pieces(black))
+		entry.endgame = endgame_kpk;
+
+	// drawish material for the side ahead
+	bool bishops_only = counts.bishops(white) == 1 && counts.bishops(black) == 1
+		&& counts.pieces(white) == 1 && counts.pieces(black) == 1;
+	for (int side = white; side <= black; side++) {
+		if (bishops_only)
+			entry.scale[side] = scale_opposite_bishops;
+		else if (!counts.pawns(side) && counts.pieceMaterial(side) - counts.pieceMaterial(side ^ 1) <= material_score[B])
+			entry.scale[side] = scale_no_pawns;
+	}
+	return entry;
+}
+
+// every key decoded into its counts
+static std::vector<MaterialEntry> initMaterialTable() {
+	std::vector<MaterialEntry> table(material_key_size);
+	for (int key = 0; key < material_key_size; key++) {
+		materialCounts counts = {};
+		for (int piece = P; piece <= k; piece++)
+			if (material_key_weight[piece])
+				counts.count[piece] = (key / material_key_weight[piece]) % (max_material_count[piece] + 1);
+		table[key] = computeEntry(counts);
+	}
+	return table;
+}
+
+const std::vector<MaterialEntry> material_table = initMaterialTable();
+
+//##################################################################################################################
+//                                                     FUNCTIONS
+//##################################################################################################################
+
+const MaterialEntry& probeMaterial(const Board& board, MaterialEntry& entry)
+{
+	if (!board.materialOverflow())
+		return material_table[board.materialKey()];
+
+	// promoted pieces beyond the key digits
+	materialCounts counts;
+	for (int piece = P; piece <= k; piece++)
+		counts.count[piece] = (piece % 6 == K) ? 0 : count_bits(board.bitboards()[piece]);
+	entry = computeEntry(counts);
+	return entry;
+}
+
+// king steps between two squares
+static inline int distance(int square_1, int square_2) {
+	int files = std::abs(square_1 % 8 - square_2 % 8);
+	int ranks = std::abs(square_1 / 8 - square_2 / 8);
+	return files > ranks ? files : ranks;
+}
+
+// king steps from the centre (0 on d4, d5, e4, e5 & 3 on the edge)
+static inline int centreDistance(int square) {
+	int file = square % 8 < 4 ? 3 - square % 8 : square % 8 - 4;
+	int rank = square / 8 < 4 ? 3 - square / 8 : square / 8 - 4;
+	return file > rank ? file : rank;
+}
+
+int evaluateEndgame(int endgame, const Board& board)
+{
+	const std::array<uint64_t, 12>& bitboards = board.bitboards();
+	int score = 0;
+
+	switch (endgame) {
+	case endgame_kxk:
+	case endgame_kbnk: {
+		// drive the bare king to the edge (the corner of the bishop's colour) & bring the kings together
+		int strong = board.occupancies()[white] != bitboards[K] ? white : black;
+		int strong_king = get_ls1b_index(bitboards[(strong == white) ? K : k]);
+		int weak_king = get_ls1b_index(bitboards[(strong == white) ? k : K]);
+
+		for (int piece = N; piece <= Q; piece++)
+			score += material_score[piece] * count_bits(bitboards[(strong == white) ? piece : piece + 6]);
+		score += known_win + 10 * (7 - distance(strong_king, weak_king));
+
+		if (endgame == endgame_kbnk) {
+			// a8 & h1 are light, h8 & a1 dark
+			int bishop = get_ls1b_index(bitboards[(strong == white) ? B : b]);
+			bool light = (bishop / 8 + bishop % 8) % 2 == 0;
+			int corner = light ? std::min(distance(weak_king, 0), distance(weak_king, 63)) : std::min(distance(weak_king, 7), distance(weak_king, 56));
+			score += 50 * (7 - corner);
+		}
+		else
+			score += 20 * centreDistance(weak_king);
+
+		return (strong == white) ? score : -score;
+	}
+
+	case endgame_kpk: {
+		// exact result from the bitbase, wins sorted by the progress of the pawn
+		int strong = bitboards[P] ? white : black;
+		int pawn = get_ls1b_index(bitboards[(strong == white) ? P : p]);
+		int strong_king = get_ls1b_index(bitboards[(strong == white) ? K : k]);
+		int weak_king = get_ls1b_index(bitboards[(strong == white) ? k : K]);
+		if (!probeKpk(strong, strong_king, pawn, weak_king, board.side()))
+			return 0;
+
+		int relative_rank = (strong == white) ? 7 - pawn / 8 : pawn / 8;
+		score = known_win + material_score[P] + 20 * relative_rank;
+		return (strong == white) ? score : -score;
+	}
+
+	default:
+		return 0;
+	}
+}
+
+int scaleFactor(int scale, const Board& board)
+{
+	switch (scale) {
+	case scale_opposite_bishops: {
+		int white_bishop = get_ls1b_index(board.bitboards()[B]);
+		int black_bishop = get_ls1b_index(board.bitboards()[b]);
+		bool opposite = (white_bishop / 8 + white_bishop % 8) % 2 != (black_bishop / 8 + black_bishop % 8) % 2;
+		return opposite ? scale_opposite : scale_normal;
+	}
+
+	case scale_no_pawns:
+		// without pawns a minor piece up is no win
+		return scale_pawnless;
+
+	default:
+		return scale_normal;
+	}
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+void materialTest()
+{
+	const char* fens[] = {
+		"8/8/4k3/8/8/3K4/8/8 w - - 0 1",
+		"8/8/4k3/8/8/3KN3/8/8 w - - 0 1",
+		"8/8/3k4/8/8/4R3/3K4/8 w - - 0 1",
+		"8/8/4k3/8/8/2BKN3/8/8 w - - 0 1",
+		"8/8/4k3/8/8/3K4/4P3/8 w - - 0 1",
+		"8/8/4k3/1P6/8/8/8/7K w - - 0 1",
+		"8/5b2/4k3/2p5/2P5/3K4/3B4/8 w - - 0 1",
+		"8/5b2/4k3/8/8/3K4/3R4/8 w - - 0 1",
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"QQQ5/8/4k3/8/8/3K4/8/8 w - - 0 1",
+	};
+	const char* endgame_names[] = { "-", "draw", "kxk", "kbnk", "kpk" };
+	const char* scale_names[] = { "-", "opposite bishops", "no pawns" };
+
+	Board board;
+	printf("\n  %-8s %6s %6s %5s %-6s %-18s %-18s %6s  %s\n\n", "key", "imb mg", "imb eg", "phase", "ending", "scale white", "scale black", "eval", "fen");
+	for (const char* fen : fens) {
+		board.parse_fen(fen);
+		MaterialEntry scratch;
+		const MaterialEntry& entry = probeMaterial(board, scratch);
+		printf("  %-8u %6d %6d %5d %-6s %-18s %-18s %6d  %s%s\n", board.materialKey(), entry.imbalance_mg, entry.imbalance_eg, std::min((int)board.phase(), max_phase),
+			endgame_names[entry.endgame], scale_names[entry.scale[white]], scale_names[entry.scale[black]], evaluate(board), fen,
+			board.materialOverflow() ? " (overflow)" : "");
+	}
+	printf("\n");
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "Board.hpp"
+
+/*
+		  material key
+
+	Mixed radix piece counts, white digits then black digits:
+
+		pawns 0-8 (x1)   knights 0-2 (x9)   bishops 0-2 (x27)   rooks 0-2 (x81)   queens 0-1 (x243)
+
+	the black counts are multiplied by 486, so every combination has its own index in [0, 486 * 486).
+	Adding or removing a piece adds or subtracts the weight of its digit. A count beyond its digit
+	(a third knight, a second queen) is tracked by the overflow counter of the board instead; while it
+	isn't 0 the entry is computed from the bitboards.
+*/
+
+const int material_key_size = 486 * 486;
+
+// weight of each piece in the material key [piece]
+const uint32_t material_key_weight[12] = { 1, 9, 27, 81, 243, 0, 486, 4374, 13122, 39366, 118098, 0 };
+
+// highest count each digit can hold [piece]
+const int max_material_count[12] = { 8, 2, 2, 2, 1, 1, 8, 2, 2, 2, 1, 1 };
+
+// specialised endgame evaluators, replacing the evaluation
+enum { endgame_none, endgame_draw, endgame_kxk, endgame_kbnk, endgame_kpk };
+
+// scale factor functions, scaling the score of the side ahead (out of scale_normal)
+enum { scale_none, scale_opposite_bishops, scale_no_pawns };
+const int scale_normal = 64;
+
+// precomputed by material key
+struct MaterialEntry {
+	// piece count imbalance (bishop pair, knights & rooks against the pawn count), white's point of view
+	int16_t imbalance_mg;
+	int16_t imbalance_eg;
+
+	// endgame evaluator & scale factor function of each side [side]
+	uint8_t endgame;
+	uint8_t scale[2];
+};
+
+// entry of the material of board, entry is filled when the counts don't fit the key (single table lookup otherwise)
+const MaterialEntry& probeMaterial(const Board& board, MaterialEntry& entry);
+
+// specialised evaluation of the endgame from white's point of view
+int evaluateEndgame(int endgame, const Board& board);
+
+// scale factor of the stronger side's score (scale_normal: unchanged)
+int scaleFactor(int scale, const Board& board);
+
+// material classification & evaluation of typical endgames
+void materialTest();
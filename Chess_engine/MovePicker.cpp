@@ -0,0 +1,203 @@
+#include "MovePicker.hpp"
+#include "Evaluation.hpp"
+#include "TranspositionTable.hpp"
+#include "See.hpp"
+#include <cstdio>
+#include <algorithm>
+
+//##################################################################################################################
+//                                                     FUNCTIONS
+//##################################################################################################################
+
+int mvvLva(const Board& board, int move) {
+	int victim = get_move_enpassant(move) ? P : board.pieceOn(get_move_target(move));
+	int score = (victim >= 0) ? material_score[victim % 6] * 8 - get_move_piece(move) % 6 : 0;
+
+	// promotions by the value of the new piece
+	if (get_move_promoted(move))
+		score += material_score[get_move_promoted(move) % 6] * 8;
+	return score;
+}
+
+//##################################################################################################################
+//                                                     MOVE PICKER METHODS
+//##################################################################################################################
+
+MovePicker::MovePicker(const Board& board, std::vector<uint64_t>* move_list, int hash_move, const int* killers, int counter_move,
+	const int(*history)[64], int thread_id, const AttackMaps* attacks)
+	: m_board(board), m_move_list(move_list), m_history(history), m_thread_id(thread_id), m_attacks(attacks)
+{
+	m_hash_move = hash_move ? board.decodeMove(hash_move) : 0;
+	if (killers) {
+		m_killers[0] = killers[0];
+		m_killers[1] = killers[1];
+	}
+	m_counter_move = counter_move;
+}
+
+MovePicker::MovePicker(const Board& board, std::vector<uint64_t>* move_list, int hash_move)
+	: m_board(board), m_move_list(move_list), m_captures_only(true)
+{
+	m_hash_move = hash_move ? board.decodeMove(hash_move) : 0;
+
+	// quiet hash moves are not searched by the quiescence
+	if (m_hash_move && !get_move_capture(m_hash_move) && !get_move_promoted(m_hash_move))
+		m_hash_move = 0;
+}
+
+uint64_t MovePicker::pickBest() {
+	int best = m_current;
+	for (int index = m_current + 1; index < m_end; index++)
+		if (m_scores[index] > m_scores[best])
+			best = index;
+
+	std::swap((*m_move_list)[m_current], (*m_move_list)[best]);
+	std::swap(m_scores[m_current], m_scores[best]);
+	return (*m_move_list)[m_current++];
+}
+
+bool MovePicker::isSpecial(int move) const {
+	return move == m_hash_move || move == m_killers[0] || move == m_killers[1] || move == m_counter_move;
+}
+
+bool MovePicker::isBadCapture(int move) const {
+	// a cheaper piece takes, no exchange needed
+	int victim = get_move_enpassant(move) ? P : m_board.pieceOn(get_move_target(move));
+	if (!get_move_promoted(move) && see_value[victim % 6] >= see_value[get_move_piece(move) % 6])
+		return false;
+	return !seeGe(m_board, move, 0);
+}
+
+int MovePicker::nextMove() {
+	int move;
+
+	switch (m_stage) {
+	case stage_hash:
+		m_stage++;
+		if (m_hash_move)
+			return m_hash_move;
+		[[fallthrough]];
+
+	case stage_init_captures:
+		m_move_list->clear();
+		m_board.generateCaptures(m_move_list);
+		m_current = 0;
+		m_end = (int)m_move_list->size();
+		for (int index = 0; index < m_end; index++)
+			m_scores[index] = mvvLva(m_board, (int)(*m_move_list)[index]);
+		m_stage++;
+		[[fallthrough]];
+
+	case stage_good_captures:
+		while (m_current < m_end) {
+			move = (int)pickBest();
+			if (move == m_hash_move)
+				continue;
+
+			// losing captures wait for the last stage
+			if (isBadCapture(move)) {
+				m_bad_captures[m_bad_count++] = move;
+				continue;
+			}
+			return move;
+		}
+		// the quiescence doesn't search losing captures
+		m_stage = m_captures_only ? stage_done : stage_killer_1;
+		return nextMove();
+
+	case stage_killer_1:
+	case stage_killer_2:
+	case stage_counter_move:
+		while (m_stage <= stage_counter_move) {
+			move = (m_stage == stage_counter_move) ? m_counter_move : m_killers[m_stage - stage_killer_1];
+			bool duplicate = (move == m_hash_move)
+				|| (m_stage >= stage_killer_2 && move == m_killers[0])
+				|| (m_stage == stage_counter_move && move == m_killers[1]);
+			m_stage++;
+
+			// a quiet move that is still pseudo legal here
+			if (move && !duplicate && !get_move_capture(move) && !get_move_promoted(move)
+				&& m_board.decodeMove(compactMove(move)) == move)
+				return move;
+		}
+		[[fallthrough]];
+
+	case stage_init_quiets:
+		// quiets are appended after the captures
+		m_current = (int)m_move_list->size();
+		m_board.generateQuiets(m_move_list);
+		m_end = (int)m_move_list->size();
+		for (int index = m_current; index < m_end; index++) {
+			int quiet = (int)(*m_move_list)[index];
+			m_scores[index] = m_history ? m_history[get_move_piece(quiet)][get_move_target(quiet)] * 8 : 0;
+
+			// pieces leave squares attacked by pawns or hanging, & avoid the ones attacked by pawns
+			if (m_attacks && get_move_piece(quiet) % 6 != P) {
+				int side = m_board.side();
+				uint64_t pawn_attacks = m_attacks->by_piece[(side == white) ? p : P];
+				uint64_t threatened = pawn_attacks | m_attacks->hanging[side];
+				if (threatened & (1ULL << get_move_source(quiet)))
+					m_scores[index] += threat_bonus;
+				if (pawn_attacks & (1ULL << get_move_target(quiet)))
+					m_scores[index] -= threat_bonus;
+			}
+
+			// helpers break ties in their own order
+			if (m_thread_id)
+				m_scores[index] += (int)(((uint32_t)quiet * 2654435761u + m_thread_id * 40503u) >> 29);
+		}
+		m_stage = stage_quiets;
+		[[fallthrough]];
+
+	case stage_quiets:
+		while (m_current < m_end) {
+			move = (int)pickBest();
+			if (!isSpecial(move))
+				return move;
+		}
+		m_stage++;
+		[[fallthrough]];
+
+	case stage_bad_captures:
+		if (m_bad_current < m_bad_count)
+			return m_bad_captures[m_bad_current++];
+		m_stage = stage_done;
+		[[fallthrough]];
+
+	default:
+		return 0;
+	}
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+void movePickerTest() {
+	Board b;
+	std::vector<uint64_t> move_list, picked;
+	move_list.reserve(max_moves);
+	int history[12][64] = {};
+
+	b.parse_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 ");
+	b.plot();
+
+	// hash move e2a6, killer a1b1, counter move e1g1
+	int killers[2] = { encode_move(56, 57, R, 0, 0, 0, 0, 0), 0 };
+	MovePicker picker(b, &move_list, compactMove(encode_move(52, 16, B, 0, 1, 0, 0, 0)), killers,
+		encode_move(60, 62, K, 0, 0, 0, 0, 1), history, 0);
+
+	printf("\n    stage  move\n\n");
+	while (int move = picker.nextMove()) {
+		printf("    %5d  %s\n", picker.stage(), moveToString(move).c_str());
+		picked.push_back(move);
+	}
+
+	// every move exactly once
+	std::vector<uint64_t> all_moves_list;
+	b.generateMoves(&all_moves_list);
+	std::sort(picked.begin(), picked.end());
+	std::sort(all_moves_list.begin(), all_moves_list.end());
+	printf("\n    Picked %d moves, generated %d, same moves: %d\n", (int)picked.size(), (int)all_moves_list.size(),
+		picked == all_moves_list);
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "Board.hpp"
+#include "AttackMaps.hpp"
+
+// move picker stages, in the order the moves are returned
+enum {
+	stage_hash,
+	stage_init_captures, stage_good_captures,
+	stage_killer_1, stage_killer_2, stage_counter_move,
+	stage_init_quiets, stage_quiets,
+	stage_bad_captures,
+	stage_done
+};
+
+// history scores are kept within [-max_history, max_history]
+const int max_history = 16384;
+
+// quiet move order bonus for saving a threatened piece (penalty for moving into pawn attacks)
+const int threat_bonus = max_history * 2;
+
+/*
+		Staged move picker
+
+	Returns the pseudo legal moves of a position one at a time, best first:
+
+		hash move        checked with decodeMove, nothing is generated
+		good captures    generateCaptures, MVV-LVA order
+		killers          the last two quiet moves that cut off at this ply
+		counter move     the quiet move that refuted the previous move
+		quiet moves      generateQuiets, history order (attack maps: threatened pieces
+		                 escaping first, pieces moving into pawn attacks last)
+		bad captures     captures with a negative static exchange evaluation
+
+	Every stage is only generated when the previous one is exhausted, so a beta
+	cutoff skips the rest of the generation work. The captures picker (quiescence)
+	stops after the good captures.
+*/
+
+class MovePicker {
+
+	const Board& m_board;
+
+	// generated moves (preallocated per ply by the caller)
+	std::vector<uint64_t>* m_move_list;
+	int m_scores[max_moves];
+
+	// next move & end of the stage in the move list
+	int m_current = 0;
+	int m_end = 0;
+
+	// losing captures, returned last
+	int m_bad_captures[max_moves];
+	int m_bad_count = 0;
+	int m_bad_current = 0;
+
+	int m_stage = stage_hash;
+	bool m_captures_only = false;
+
+	// full moves of the hash, killer & counter move stages (0 if none)
+	int m_hash_move = 0;
+	int m_killers[2] = {};
+	int m_counter_move = 0;
+
+	// quiet move history [piece][target square], perturbed by helper threads
+	const int (*m_history)[64] = nullptr;
+	int m_thread_id = 0;
+
+	// attack maps of the static evaluation (optional)
+	const AttackMaps* m_attacks = nullptr;
+
+	// best remaining move of the stage moved to the current position
+	uint64_t pickBest();
+
+	// already returned by the hash, killer or counter move stage
+	bool isSpecial(int move) const;
+
+	// capture that loses material (SEE < 0)
+	bool isBadCapture(int move) const;
+
+public:
+
+	// all moves: hash move, captures, killers, counter move, quiets, bad captures
+	MovePicker(const Board& board, std::vector<uint64_t>* move_list, int hash_move, const int* killers, int counter_move,
+		const int(*history)[64], int thread_id, const AttackMaps* attacks = nullptr);
+
+	// quiescence: hash move & captures only
+	MovePicker(const Board& board, std::vector<uint64_t>* move_list, int hash_move);
+
+	// next pseudo legal move, 0 when there are no more moves
+	int nextMove();
+
+	int stage() const { return m_stage; }
+};
+
+// most valuable victim, least valuable attacker
+int mvvLva(const Board& board, int move);
+
+void movePickerTest();
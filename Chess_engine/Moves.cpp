@@ -1,5 +1,6 @@
 #include "Moves.hpp"
 #include "Board.hpp"
+#include <cstring>
 
 // set/get/pop bit macros
 #define set_bit(bitboard, square) ((bitboard) |= (1ULL << (square)))
@@ -54,6 +55,24 @@ void Moves::initLeapersAttacks()
     }
 }
 
+// init pawn structure masks
+void Moves::initPawnMasks()
+{
+    //loop over 64 board squares
+    for (int square = 0; square < 64; square++)
+    {
+        m_file_masks[square] = maskFile(square);
+        m_adjacent_files_masks[square] = maskAdjacentFiles(square);
+
+        for (int side = 0; side < 2; side++)
+        {
+            m_forward_file_masks[side][square] = maskForwardFile(side, square);
+            m_pawn_attack_spans[side][square] = maskPawnAttackSpan(side, square);
+            m_passed_pawn_masks[side][square] = m_forward_file_masks[side][square] | m_pawn_attack_spans[side][square];
+        }
+    }
+}
+
 // init slider piece's attack tables
 void Moves::initSlidersAttacks(int bishop)
 {
@@ -116,6 +135,9 @@ void Moves::initAll()
     // init leaper pieces attacks
     initLeapersAttacks();
 
+    // init pawn structure masks
+    initPawnMasks();
+
     // init slider pieces attacks
     initSlidersAttacks(0);
     initSlidersAttacks(1);
@@ -124,19 +146,19 @@ void Moves::initAll()
     //init_magic_numbers();
 }
 
-uint64_t Moves::getPawnAttacks(int side, uint8_t square) {
+uint64_t Moves::getPawnAttacks(int side, uint8_t square) const {
     return m_pawn_attacks[side][square];
 }
 
-uint64_t Moves::getKnightAttacks(uint8_t square) {
+uint64_t Moves::getKnightAttacks(uint8_t square) const {
     return m_knight_attacks[square];
 }
 
-uint64_t Moves::getKingAttacks(uint8_t square) {
+uint64_t Moves::getKingAttacks(uint8_t square) const {
     return m_king_attacks[square];
 }
 
-uint64_t Moves::getBishopAttacks(uint8_t square, uint64_t occupancy)
+uint64_t Moves::getBishopAttacks(uint8_t square, uint64_t occupancy) const
 {
     // get bishop attacks assuming current board occupancy
     occupancy &= m_bishop_masks[square];
@@ -147,7 +169,7 @@ uint64_t Moves::getBishopAttacks(uint8_t square, uint64_t occupancy)
     return m_bishop_attacks_ptr[square * 512 + occupancy];
 }
 
-uint64_t Moves::getRookAttacks(uint8_t square, uint64_t occupancy)
+uint64_t Moves::getRookAttacks(uint8_t square, uint64_t occupancy) const
 {
     // get bishop attacks assuming current board occupancy
     occupancy &= m_rook_masks[square];
@@ -158,7 +180,7 @@ uint64_t Moves::getRookAttacks(uint8_t square, uint64_t occupancy)
     return m_rook_attacks_ptr[square * 4096 + occupancy];
 }
 
-uint64_t Moves::getQueenAttacks(uint8_t square, uint64_t occupancy) {
+uint64_t Moves::getQueenAttacks(uint8_t square, uint64_t occupancy) const {
     uint64_t queen_attacks = 0ULL;
 
     queen_attacks |= getBishopAttacks(square, occupancy);
@@ -171,6 +193,15 @@ uint64_t Moves::getQueenAttacks(uint8_t square, uint64_t occupancy) {
 //Functions
 //==================================================================================================================
 
+// attack tables are read only once initialized, so every board (and thread) uses the same instance
+const Moves& sharedMoves() {
+    // thread safe one time initialization
+    static Moves moves;
+    static const bool initialized = (moves.initAll(), true);
+    (void)initialized;
+    return moves;
+}
+
 uint64_t maskPawnAttacks(bool side, uint8_t square) {
 	uint64_t attacks = 0ULL;
 	uint64_t bitboard = 0ULL;
@@ -245,6 +276,50 @@ uint64_t maskKingAttacks(uint8_t square){
     return attacks;
 }
 
+uint64_t maskFile(uint8_t square) {
+    uint64_t mask = 0ULL;
+
+    // every rank of the square's file
+    for (int rank = 0; rank < 8; rank++)
+        set_bit(mask, rank * 8 + square % 8);
+
+    return mask;
+}
+
+uint64_t maskAdjacentFiles(uint8_t square) {
+    uint64_t mask = 0ULL;
+
+    // files left & right of the square, if on the board
+    if (square % 8 > 0) mask |= maskFile(square - 1);
+    if (square % 8 < 7) mask |= maskFile(square + 1);
+
+    return mask;
+}
+
+uint64_t maskForwardFile(bool side, uint8_t square) {
+    uint64_t mask = 0ULL;
+
+    // white pawns advance towards rank 8 (lower squares), black pawns towards rank 1
+    if (!side)
+        for (int target = square - 8; target >= 0; target -= 8)
+            set_bit(mask, target);
+    else
+        for (int target = square + 8; target < 64; target += 8)
+            set_bit(mask, target);
+
+    return mask;
+}
+
+uint64_t maskPawnAttackSpan(bool side, uint8_t square) {
+    uint64_t mask = 0ULL;
+
+    // adjacent file squares of the ranks in front of the pawn
+    if (square % 8 > 0) mask |= maskForwardFile(side, square - 1);
+    if (square % 8 < 7) mask |= maskForwardFile(side, square + 1);
+
+    return mask;
+}
+
 uint64_t maskBishopAttacks(uint8_t square) {
     // result attacks bitboard
     uint64_t attacks = 0ULL;
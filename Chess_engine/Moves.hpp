@@ -174,6 +174,21 @@ class Moves {
 	// king attacks table [square]
 	uint64_t m_king_attacks[64] = {};
 
+	// file of the square [square]
+	uint64_t m_file_masks[64] = {};
+
+	// files next to the file of the square [square]
+	uint64_t m_adjacent_files_masks[64] = {};
+
+	// squares in front of a pawn on its file [side][square]
+	uint64_t m_forward_file_masks[2][64] = {};
+
+	// squares a pawn can attack while it advances (adjacent files in front of it) [side][square]
+	uint64_t m_pawn_attack_spans[2][64] = {};
+
+	// squares in front of a pawn on its own & adjacent files, a pawn without enemy pawns there is passed [side][square]
+	uint64_t m_passed_pawn_masks[2][64] = {};
+
     // bishop attack masks
     uint64_t m_bishop_masks[64] = {};
 
@@ -198,36 +213,62 @@ public:
 
     ~Moves() {
         if (m_rook_attacks_ptr != nullptr) {
-            delete m_bishop_attacks_ptr;
-            delete m_rook_attacks_ptr;
+            delete[] m_bishop_attacks_ptr;
+            delete[] m_rook_attacks_ptr;
         }
     }
 
+    // owns the attack tables, share it instead of copying
+    Moves(const Moves&) = delete;
+    Moves& operator=(const Moves&) = delete;
+
     void initLeapersAttacks();
+    void initPawnMasks();
     void initSlidersAttacks(int bishop);
     void initAll();
     void initMagicNumbers();
 
-    uint64_t getPawnAttacks(int side, uint8_t square);
+    uint64_t getPawnAttacks(int side, uint8_t square) const;
+
+    uint64_t getKnightAttacks(uint8_t square) const;
+
+    uint64_t getKingAttacks(uint8_t square) const;
 
-    uint64_t getKnightAttacks(uint8_t square);
+    uint64_t getBishopAttacks(uint8_t square, uint64_t occupancy) const;
 
-    uint64_t getKingAttacks(uint8_t square);
+    uint64_t getRookAttacks(uint8_t square, uint64_t occupancy) const;
 
-    uint64_t getBishopAttacks(uint8_t square, uint64_t occupancy);
+    uint64_t getQueenAttacks(uint8_t square, uint64_t occupancy) const;
 
-    uint64_t getRookAttacks(uint8_t square, uint64_t occupancy);
+    uint64_t getFileMask(uint8_t square) const { return m_file_masks[square]; }
 
-    uint64_t getQueenAttacks(uint8_t square, uint64_t occupancy);
+    uint64_t getAdjacentFilesMask(uint8_t square) const { return m_adjacent_files_masks[square]; }
+
+    uint64_t getForwardFileMask(int side, uint8_t square) const { return m_forward_file_masks[side][square]; }
+
+    uint64_t getPawnAttackSpan(int side, uint8_t square) const { return m_pawn_attack_spans[side][square]; }
+
+    uint64_t getPassedPawnMask(int side, uint8_t square) const { return m_passed_pawn_masks[side][square]; }
 
 };
 
+// initialized attack tables shared by the whole process
+const Moves& sharedMoves();
+
 uint64_t maskPawnAttacks(bool side, uint8_t square);
 
 uint64_t maskKnightAttacks(uint8_t square);
 
 uint64_t maskKingAttacks(uint8_t square);
 
+uint64_t maskFile(uint8_t square);
+
+uint64_t maskAdjacentFiles(uint8_t square);
+
+uint64_t maskForwardFile(bool side, uint8_t square);
+
+uint64_t maskPawnAttackSpan(bool side, uint8_t square);
+
 uint64_t maskBishopAttacks(uint8_t square);
 
 uint64_t maskRookAttacks(uint8_t square);
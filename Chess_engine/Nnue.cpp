@@ -0,0 +1,300 @@
+#include "Nnue.hpp"
+#include "Board.hpp"
+#include "Bench.hpp"
+#include "Utility.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+//##################################################################################################################
+//                                                     SIMD
+//##################################################################################################################
+
+// int16 lanes of a register, the scalar fallback works on one lane at a time
+#if defined(__AVX2__)
+
+typedef __m256i vec_t;
+const int vec_lanes = 16;
+static inline vec_t vecLoad(const int16_t* p) { return _mm256_load_si256((const __m256i*)p); }
+static inline void vecStore(int16_t* p, vec_t v) { _mm256_store_si256((__m256i*)p, v); }
+static inline vec_t vecAdd16(vec_t a, vec_t b) { return _mm256_add_epi16(a, b); }
+static inline vec_t vecSub16(vec_t a, vec_t b) { return _mm256_sub_epi16(a, b); }
+static inline vec_t vecClamp16(vec_t v) { return _mm256_min_epi16(_mm256_max_epi16(v, _mm256_setzero_si256()), _mm256_set1_epi16(nnue_qa)); }
+static inline vec_t vecMadd16(vec_t a, vec_t b) { return _mm256_madd_epi16(a, b); }
+static inline vec_t vecAdd32(vec_t a, vec_t b) { return _mm256_add_epi32(a, b); }
+static inline vec_t vecZero() { return _mm256_setzero_si256(); }
+static inline int vecSum32(vec_t v) {
+	__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+	return _mm_cvtsi128_si32(sum);
+}
+
+#elif defined(__SSE2__)
+
+typedef __m128i vec_t;
+const int vec_lanes = 8;
+static inline vec_t vecLoad(const int16_t* p) { return _mm_load_si128((const __m128i*)p); }
+static inline void vecStore(int16_t* p, vec_t v) { _mm_store_si128((__m128i*)p, v); }
+static inline vec_t vecAdd16(vec_t a, vec_t b) { return _mm_add_epi16(a, b); }
+static inline vec_t vecSub16(vec_t a, vec_t b) { return _mm_sub_epi16(a, b); }
+static inline vec_t vecClamp16(vec_t v) { return _mm_min_epi16(_mm_max_epi16(v, _mm_setzero_si128()), _mm_set1_epi16(nnue_qa)); }
+static inline vec_t vecMadd16(vec_t a, vec_t b) { return _mm_madd_epi16(a, b); }
+static inline vec_t vecAdd32(vec_t a, vec_t b) { return _mm_add_epi32(a, b); }
+static inline vec_t vecZero() { return _mm_setzero_si128(); }
+static inline int vecSum32(vec_t v) {
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0x4e));
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0xb1));
+	return _mm_cvtsi128_si32(v);
+}
+
+#endif
+
+//##################################################################################################################
+//                                                     NETWORK METHODS
+//##################################################################################################################
+
+bool NnueNetwork::load(const std::string& path) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+		return false;
+
+	char magic[4];
+	uint32_t header[3];
+	in.read(magic, 4);
+	in.read((char*)header, sizeof(header));
+	if (!in || std::memcmp(magic, "CNUE", 4) || header[0] != nnue_version || header[1] != nnue_inputs || header[2] != nnue_hidden)
+		return false;
+
+	// read into a copy, a truncated file leaves the network unchanged
+	std::unique_ptr<NnueNetwork> network(new NnueNetwork);
+	in.read((char*)network->feature_weights, sizeof(feature_weights));
+	in.read((char*)network->feature_bias, sizeof(feature_bias));
+	in.read((char*)network->output_weights, sizeof(output_weights));
+	in.read((char*)&network->output_bias, sizeof(output_bias));
+	if (!in)
+		return false;
+
+	*this = *network;
+	return true;
+}
+
+bool NnueNetwork::save(const std::string& path) const {
+	std::ofstream out(path, std::ios::binary);
+	if (!out)
+		return false;
+
+	const uint32_t header[3] = { nnue_version, (uint32_t)nnue_inputs, (uint32_t)nnue_hidden };
+	out.write("CNUE", 4);
+	out.write((const char*)header, sizeof(header));
+	out.write((const char*)feature_weights, sizeof(feature_weights));
+	out.write((const char*)feature_bias, sizeof(feature_bias));
+	out.write((const char*)output_weights, sizeof(output_weights));
+	out.write((const char*)&output_bias, sizeof(output_bias));
+	return (bool)out;
+}
+
+void NnueNetwork::randomize(uint64_t seed) {
+	uint64_t state = seed ? seed : 1;
+	auto next = [&state](int range) {
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return (int)((state * 2685821657736338717ULL) >> 40) % range;
+	};
+
+	for (int feature = 0; feature < nnue_inputs; feature++)
+		for (int index = 0; index < nnue_hidden; index++)
+			feature_weights[feature][index] = (int16_t)(next(64) - 32);
+	for (int index = 0; index < nnue_hidden; index++)
+		feature_bias[index] = (int16_t)next(128);
+	for (int index = 0; index < 2 * nnue_hidden; index++)
+		output_weights[index] = (int16_t)(next(128) - 64);
+	output_bias = 0;
+}
+
+void NnueNetwork::refresh(const std::array<uint64_t, 12>& bitboards, NnueAccumulator& accumulator) const {
+	for (int perspective = 0; perspective < 2; perspective++) {
+		int16_t* values = accumulator.values[perspective];
+		std::memcpy(values, feature_bias, sizeof(feature_bias));
+
+		for (int piece = 0; piece < 12; piece++) {
+			uint64_t bitboard = bitboards[piece];
+			while (bitboard) {
+				int square = get_ls1b_index(bitboard);
+				const int16_t* weights = feature_weights[nnueFeature(perspective, piece, square)];
+#if defined(__AVX2__) || defined(__SSE2__)
+				for (int index = 0; index < nnue_hidden; index += vec_lanes)
+					vecStore(values + index, vecAdd16(vecLoad(values + index), vecLoad(weights + index)));
+#else
+				for (int index = 0; index < nnue_hidden; index++)
+					values[index] += weights[index];
+#endif
+				bitboard &= bitboard - 1;
+			}
+		}
+	}
+}
+
+void NnueNetwork::update(const NnueAccumulator& from, NnueAccumulator& to, const int* added, int added_count, const int* removed, int removed_count) const {
+	for (int perspective = 0; perspective < 2; perspective++) {
+		const int16_t* add[3];
+		const int16_t* sub[3];
+		for (int i = 0; i < added_count; i++)
+			add[i] = feature_weights[nnueFeature(perspective, added[i] / 64, added[i] % 64)];
+		for (int i = 0; i < removed_count; i++)
+			sub[i] = feature_weights[nnueFeature(perspective, removed[i] / 64, removed[i] % 64)];
+
+		const int16_t* source = from.values[perspective];
+		int16_t* target = to.values[perspective];
+
+#if defined(__AVX2__) || defined(__SSE2__)
+		for (int index = 0; index < nnue_hidden; index += vec_lanes) {
+			vec_t values = vecLoad(source + index);
+			for (int i = 0; i < removed_count; i++)
+				values = vecSub16(values, vecLoad(sub[i] + index));
+			for (int i = 0; i < added_count; i++)
+				values = vecAdd16(values, vecLoad(add[i] + index));
+			vecStore(target + index, values);
+		}
+#else
+		for (int index = 0; index < nnue_hidden; index++) {
+			int16_t value = source[index];
+			for (int i = 0; i < removed_count; i++)
+				value -= sub[i][index];
+			for (int i = 0; i < added_count; i++)
+				value += add[i][index];
+			target[index] = value;
+		}
+#endif
+	}
+}
+
+int NnueNetwork::evaluate(const NnueAccumulator& accumulator, int side) const {
+	const int16_t* us = accumulator.values[side];
+	const int16_t* them = accumulator.values[side ^ 1];
+	int sum = 0;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+	vec_t total = vecZero();
+	for (int index = 0; index < nnue_hidden; index += vec_lanes) {
+		total = vecAdd32(total, vecMadd16(vecClamp16(vecLoad(us + index)), vecLoad(output_weights + index)));
+		total = vecAdd32(total, vecMadd16(vecClamp16(vecLoad(them + index)), vecLoad(output_weights + nnue_hidden + index)));
+	}
+	sum = vecSum32(total);
+#else
+	for (int index = 0; index < nnue_hidden; index++) {
+		int us_value = us[index] < 0 ? 0 : (us[index] > nnue_qa ? nnue_qa : us[index]);
+		int them_value = them[index] < 0 ? 0 : (them[index] > nnue_qa ? nnue_qa : them[index]);
+		sum += us_value * output_weights[index] + them_value * output_weights[nnue_hidden + index];
+	}
+#endif
+
+	return (int)((int64_t)(sum + output_bias) * nnue_scale / (nnue_qa * nnue_qb));
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+// compare the incremental accumulators with refreshed ones at every node
+static uint64_t accumulatorWalk(Board* b, const NnueNetwork& network, int depth)
+{
+	NnueAccumulator expected;
+	network.refresh(b->bitboards(), expected);
+	uint64_t mismatches = std::memcmp(&expected, &b->accumulator(), sizeof(expected)) != 0;
+	if (depth == 0)
+		return mismatches;
+
+	std::vector<uint64_t> move_list;
+	b->generateMoves(&move_list);
+	for (uint64_t move : move_list) {
+		b->copyBoard();
+		if (!b->makeMove((int)move, all_moves)) {
+			b->clearCopy();
+			continue;
+		}
+		mismatches += accumulatorWalk(b, network, depth - 1);
+		b->takeBack();
+	}
+	return mismatches;
+}
+
+void nnueTest(std::string path)
+{
+	std::unique_ptr<NnueNetwork> network(new NnueNetwork);
+	if (path.empty() || !network->load(path)) {
+		if (!path.empty())
+			printf("Could not load %s, using a random network\n", path.c_str());
+		network->randomize(1070372);
+	}
+
+#if defined(__AVX2__)
+	const char* simd = "avx2";
+#elif defined(__SSE2__)
+	const char* simd = "sse2";
+#else
+	const char* simd = "scalar";
+#endif
+	printf("\n     NNUE (768 -> %d)x2 -> 1, %s\n\n", nnue_hidden, simd);
+
+	Board b;
+	b.setNetwork(network.get());
+	for (const BenchPosition& position : benchPositions()) {
+		b.parse_fen(position.fen);
+		printf("  %-12s eval %6d  accumulator mismatches %llu\n", position.name.c_str(), b.nnueEvaluate(),
+			(unsigned long long)accumulatorWalk(&b, *network, 3));
+	}
+
+	// evaluations per second: full refresh against the incrementally updated accumulator
+	const int calls = 200000;
+	NnueAccumulator accumulator;
+	volatile int sink = 0;
+	b.parse_fen(benchPositions()[1].fen);
+
+	uint64_t start = get_time_ns();
+	for (int i = 0; i < calls; i++) {
+		network->refresh(b.bitboards(), accumulator);
+		sink = sink + network->evaluate(accumulator, b.side());
+	}
+	double refresh_seconds = (get_time_ns() - start) / 1e9;
+
+	start = get_time_ns();
+	for (int i = 0; i < calls; i++)
+		sink = sink + b.nnueEvaluate();
+	double evaluate_seconds = (get_time_ns() - start) / 1e9;
+
+	printf("\n  refresh + evaluate %10.2f Mevals/s\n", calls / refresh_seconds / 1e6);
+	printf("  evaluate           %10.2f Mevals/s\n", calls / evaluate_seconds / 1e6);
+
+	// cost of the incremental updates in make/unmake
+	for (int with_network = 0; with_network < 2; with_network++) {
+		Board perft_board;
+		if (with_network)
+			perft_board.setNetwork(network.get());
+		perft_board.parse_fen(benchPositions()[1].fen);
+
+		std::vector<uint64_t> move_list;
+		perft_board.generateMoves(&move_list);
+		uint64_t moves = 0;
+		start = get_time_ns();
+		for (int i = 0; i < calls / 40; i++) {
+			for (uint64_t move : move_list) {
+				perft_board.copyBoard();
+				if (!perft_board.makeMove((int)move, all_moves)) {
+					perft_board.clearCopy();
+					continue;
+				}
+				moves++;
+				perft_board.takeBack();
+			}
+		}
+		double seconds = (get_time_ns() - start) / 1e9;
+		printf("  make/unmake %-7s %9.2f Mmoves/s\n", with_network ? "(nnue)" : "", moves / seconds / 1e6);
+	}
+	printf("\n");
+}
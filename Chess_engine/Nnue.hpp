@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <array>
+
+/*
+		  network (768 -> 256)x2 -> 1
+
+	inputs     piece (12) x square (64) of each perspective, black's mirrored vertically & colors swapped
+	hidden     int16 accumulator per perspective, clipped to [0, nnue_qa]
+	output     side to move accumulator then the other one, dot product with the output weights
+
+	file: "CNUE", version, inputs, hidden (uint32), then little endian
+	int16 feature weights [768][256], int16 feature biases [256], int16 output weights [512], int32 output bias
+*/
+
+const int nnue_inputs = 768;
+const int nnue_hidden = 256;
+
+// quantization of the feature transformer & the output layer, centipawns per output unit
+const int nnue_qa = 255;
+const int nnue_qb = 64;
+const int nnue_scale = 400;
+
+const uint32_t nnue_version = 1;
+
+// hidden layer of both perspectives [white, black]
+struct alignas(64) NnueAccumulator {
+	int16_t values[2][nnue_hidden];
+};
+
+struct alignas(64) NnueNetwork {
+	int16_t feature_weights[nnue_inputs][nnue_hidden];
+	int16_t feature_bias[nnue_hidden];
+	int16_t output_weights[2 * nnue_hidden];
+	int32_t output_bias;
+
+	// false (network unchanged) if the file is missing or doesn't match the architecture
+	bool load(const std::string& path);
+
+	bool save(const std::string& path) const;
+
+	// small deterministic weights, for tests & benchmarks without a trained network
+	void randomize(uint64_t seed);
+
+	// accumulator of the pieces on bitboards from scratch
+	void refresh(const std::array<uint64_t, 12>& bitboards, NnueAccumulator& accumulator) const;
+
+	// to = from with the removed features subtracted & the added ones added (feature: piece * 64 + square)
+	void update(const NnueAccumulator& from, NnueAccumulator& to, const int* added, int added_count, const int* removed, int removed_count) const;
+
+	// score in centipawns from the side to move point of view
+	int evaluate(const NnueAccumulator& accumulator, int side) const;
+};
+
+// input of piece on square seen by perspective
+inline int nnueFeature(int perspective, int piece, int square) {
+	return perspective == 0 ? piece * 64 + square : ((piece + 6) % 12) * 64 + (square ^ 56);
+}
+
+// incremental evaluation throughput against full refreshes (random network unless path is given)
+void nnueTest(std::string path);
@@ -0,0 +1,181 @@
+#include "Pawns.hpp"
+#include "Search.hpp"
+#include "Bench.hpp"
+#include <cstdio>
+#include <algorithm>
+
+//##################################################################################################################
+//                                                     VARIABLES
+//##################################################################################################################
+
+// set/pop bit macros
+#define set_bit(bitboard, square) ((bitboard) |= (1ULL << (square)))
+#define pop_bit(bitboard, square) ((bitboard) &= ~(1ULL << (square)))
+
+// pawn structure penalties, midgame & endgame
+const int doubled_mg = -10, doubled_eg = -20;
+const int isolated_mg = -10, isolated_eg = -15;
+const int backward_mg = -8, backward_eg = -10;
+
+// passed pawn bonus [relative rank]
+const int passed_mg[8] = { 0, 5, 10, 15, 25, 40, 70, 0 };
+const int passed_eg[8] = { 0, 10, 20, 35, 60, 100, 150, 0 };
+
+// own pawns one & two ranks in front of the king, on its own & adjacent files (midgame only)
+const int shield_first_rank = 12;
+const int shield_second_rank = 6;
+
+//##################################################################################################################
+//                                                     PAWN TABLE METHODS
+//##################################################################################################################
+
+PawnTable::PawnTable(size_t entries) : m_entries(entries) {}
+
+// an empty entry (key 0) holds exactly the scores of a position without pawns, so it needs no valid flag
+void PawnTable::clear() {
+	std::fill(m_entries.begin(), m_entries.end(), PawnEntry());
+	m_probes = m_hits = 0;
+}
+
+PawnEntry* PawnTable::probe(const Board& board) {
+	uint64_t key = board.pawnKey();
+	PawnEntry* entry = &m_entries[key & (m_entries.size() - 1)];
+	m_probes++;
+
+	if (entry->key == key) {
+		m_hits++;
+		return entry;
+	}
+
+	// replace whatever was there
+	*entry = PawnEntry();
+	entry->key = key;
+	evaluatePawnStructure(board, *entry);
+	return entry;
+}
+
+//##################################################################################################################
+//                                                     FUNCTIONS
+//##################################################################################################################
+
+void evaluatePawnStructure(const Board& board, PawnEntry& entry)
+{
+	const Moves& moves = sharedMoves();
+	int score_mg = 0, score_eg = 0;
+
+	for (int side = white; side <= black; side++) {
+		uint64_t own = board.bitboards()[(side == white) ? P : p];
+		uint64_t enemy = board.bitboards()[(side == white) ? p : P];
+		int sign = (side == white) ? 1 : -1;
+
+		uint64_t bitboard = own;
+		while (bitboard) {
+			int square = get_ls1b_index(bitboard);
+			int stop_square = (side == white) ? square - 8 : square + 8;
+			int relative_rank = (side == white) ? 7 - square / 8 : square / 8;
+
+			entry.pawn_attacks[side] |= moves.getPawnAttacks(side, square);
+			entry.pawn_attack_spans[side] |= moves.getPawnAttackSpan(side, square);
+
+			// another own pawn in front on the same file
+			bool doubled = own & moves.getForwardFileMask(side, square);
+			if (doubled) {
+				score_mg += sign * doubled_mg;
+				score_eg += sign * doubled_eg;
+			}
+
+			// no own pawns on the adjacent files
+			if (!(own & moves.getAdjacentFilesMask(square))) {
+				score_mg += sign * isolated_mg;
+				score_eg += sign * isolated_eg;
+			}
+
+			// no own pawn beside or behind it on the adjacent files & an enemy pawn controls its stop square
+			else if (!(own & moves.getPawnAttackSpan(side ^ 1, stop_square)) && (moves.getPawnAttacks(side, stop_square) & enemy)) {
+				score_mg += sign * backward_mg;
+				score_eg += sign * backward_eg;
+			}
+
+			// no enemy pawn can stop or capture it (the rear one of doubled pawns doesn't count)
+			if (!doubled && !(enemy & moves.getPassedPawnMask(side, square))) {
+				set_bit(entry.passed_pawns[side], square);
+				score_mg += sign * passed_mg[relative_rank];
+				score_eg += sign * passed_eg[relative_rank];
+			}
+
+			pop_bit(bitboard, square);
+		}
+	}
+
+	entry.score_mg = score_mg;
+	entry.score_eg = score_eg;
+}
+
+int pawnShield(const Board& board, PawnEntry& entry, int side)
+{
+	int king_square = get_ls1b_index(board.bitboards()[(side == white) ? K : k]);
+
+	if (entry.shield_king_square[side] != king_square) {
+		uint64_t own = board.bitboards()[(side == white) ? P : p];
+		uint64_t shield = own & sharedMoves().getPassedPawnMask(side, king_square);
+		int first_rank = (side == white) ? king_square / 8 - 1 : king_square / 8 + 1;
+		int second_rank = (side == white) ? king_square / 8 - 2 : king_square / 8 + 2;
+
+		int score = 0;
+		if (first_rank >= 0 && first_rank < 8)
+			score += shield_first_rank * count_bits(shield & (0xffULL << (first_rank * 8)));
+		if (second_rank >= 0 && second_rank < 8)
+			score += shield_second_rank * count_bits(shield & (0xffULL << (second_rank * 8)));
+
+		entry.shield_king_square[side] = king_square;
+		entry.shield_score[side] = score;
+	}
+	return entry.shield_score[side];
+}
+
+void evaluatePawns(const Board& board, PawnTable* pawn_table, int& score_mg, int& score_eg)
+{
+	PawnEntry local;
+	PawnEntry* entry = &local;
+	if (pawn_table)
+		entry = pawn_table->probe(board);
+	else
+		evaluatePawnStructure(board, local);
+
+	score_mg = entry->score_mg + pawnShield(board, *entry, white) - pawnShield(board, *entry, black);
+	score_eg = entry->score_eg;
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+void pawnHashTest(int depth)
+{
+	TranspositionTable tt(16);
+	Board b;
+
+	printf("\n     Pawn hash table: depth %d on %d positions\n", depth, (int)benchPositions().size());
+	printf("\n  %-12s %12s %12s %12s %9s\n\n", "position", "nodes", "probes", "hits", "hit rate");
+
+	uint64_t total_probes = 0, total_hits = 0;
+	for (const BenchPosition& position : benchPositions()) {
+		// every position starts from empty tables
+		Search search;
+		search.setTranspositionTable(&tt);
+		tt.clear();
+		b.parse_fen(position.fen);
+		search.setPosition(b);
+		SearchResult result = search.searchPosition(depth, false);
+
+		const PawnTable& pawn_table = search.pawnTable();
+		total_probes += pawn_table.probes();
+		total_hits += pawn_table.hits();
+		printf("  %-12s %12llu %12llu %12llu %8.1f%%\n", position.name.c_str(), (unsigned long long)result.nodes,
+			(unsigned long long)pawn_table.probes(), (unsigned long long)pawn_table.hits(),
+			pawn_table.probes() ? 100.0 * pawn_table.hits() / pawn_table.probes() : 0.0);
+	}
+
+	printf("\n  %-12s %12s %12llu %12llu %8.1f%%\n\n", "total", "", (unsigned long long)total_probes, (unsigned long long)total_hits,
+		total_probes ? 100.0 * total_hits / total_probes : 0.0);
+}
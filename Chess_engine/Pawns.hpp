@@ -0,0 +1,54 @@
+#pragma once
+#include "Board.hpp"
+#include <vector>
+
+// pawn table entries per thread (a power of two)
+const size_t pawn_table_entries = 16384;
+
+// pawn structure of one pawn key, scores from white's point of view
+struct PawnEntry {
+	uint64_t key = 0;
+	int16_t score_mg = 0;
+	int16_t score_eg = 0;
+
+	// passed pawns, squares attacked by pawns & squares pawns can attack while advancing [side]
+	uint64_t passed_pawns[2] = {};
+	uint64_t pawn_attacks[2] = {};
+	uint64_t pawn_attack_spans[2] = {};
+
+	// pawn shield score of the king square it was computed for (-1: none yet) [side]
+	int8_t shield_king_square[2] = { -1, -1 };
+	int16_t shield_score[2] = {};
+};
+
+class PawnTable {
+
+	std::vector<PawnEntry> m_entries;
+
+	uint64_t m_probes = 0;
+	uint64_t m_hits = 0;
+
+public:
+
+	explicit PawnTable(size_t entries = pawn_table_entries);
+
+	// entry of the pawn structure of board, evaluated on a miss
+	PawnEntry* probe(const Board& board);
+
+	void clear();
+
+	uint64_t probes() const { return m_probes; }
+	uint64_t hits() const { return m_hits; }
+};
+
+// passed, isolated, doubled & backward pawns of board
+void evaluatePawnStructure(const Board& board, PawnEntry& entry);
+
+// pawn shield in front of the king of side (midgame only), cached in the entry for the king square
+int pawnShield(const Board& board, PawnEntry& entry, int side);
+
+// pawn structure & pawn shields, midgame & endgame scores from white's point of view (pawn_table optional)
+void evaluatePawns(const Board& board, PawnTable* pawn_table, int& score_mg, int& score_eg);
+
+// pawn table hit rate of searches on the bench positions
+void pawnHashTest(int depth);
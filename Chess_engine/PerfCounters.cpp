@@ -0,0 +1,166 @@
+#include "PerfCounters.hpp"
+#include <cstdio>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+//##################################################################################################################
+//                                                     VARIABLES
+//##################################################################################################################
+
+// event names (same order as the perf event enum)
+const char* perf_event_names[perf_event_count] = {
+	"cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"
+};
+
+#if defined(__linux__)
+
+// perf type & config of every event
+const uint32_t perf_event_types[perf_event_count] = {
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_HW_CACHE,
+	PERF_TYPE_HW_CACHE,
+	PERF_TYPE_HARDWARE
+};
+
+const uint64_t perf_event_configs[perf_event_count] = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+	PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+	PERF_COUNT_HW_BRANCH_MISSES
+};
+
+// open one disabled counter on the calling process (and the threads it spawns later)
+static int openPerfEvent(uint32_t type, uint64_t config) {
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = 1;
+	attr.inherit = 1;
+	// user space only, which is also what unprivileged containers usually allow
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+#endif
+
+//##################################################################################################################
+//                                                     PERF COUNTERS METHODS
+//##################################################################################################################
+
+PerfCounters::PerfCounters() {
+	for (int event = 0; event < perf_event_count; ++event) {
+#if defined(__linux__)
+		// fails with EACCES/ENOENT/ENOSYS when counters are not permitted, the event just stays disabled
+		m_fds[event] = openPerfEvent(perf_event_types[event], perf_event_configs[event]);
+#else
+		m_fds[event] = -1;
+#endif
+	}
+}
+
+PerfCounters::~PerfCounters() {
+#if defined(__linux__)
+	for (int event = 0; event < perf_event_count; ++event)
+		if (m_fds[event] != -1)
+			close(m_fds[event]);
+#endif
+}
+
+bool PerfCounters::available() const {
+	for (int event = 0; event < perf_event_count; ++event)
+		if (m_fds[event] != -1)
+			return true;
+	return false;
+}
+
+void PerfCounters::reset() {
+#if defined(__linux__)
+	for (int event = 0; event < perf_event_count; ++event)
+		if (m_fds[event] != -1)
+			ioctl(m_fds[event], PERF_EVENT_IOC_RESET, 0);
+#endif
+}
+
+void PerfCounters::enable() {
+#if defined(__linux__)
+	for (int event = 0; event < perf_event_count; ++event)
+		if (m_fds[event] != -1)
+			ioctl(m_fds[event], PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+void PerfCounters::disable() {
+#if defined(__linux__)
+	for (int event = 0; event < perf_event_count; ++event)
+		if (m_fds[event] != -1)
+			ioctl(m_fds[event], PERF_EVENT_IOC_DISABLE, 0);
+#endif
+}
+
+void PerfCounters::start() {
+	reset();
+	enable();
+}
+
+PerfSample PerfCounters::read() const {
+	PerfSample sample;
+#if defined(__linux__)
+	for (int event = 0; event < perf_event_count; ++event) {
+		if (m_fds[event] == -1)
+			continue;
+
+		// value, time enabled, time running
+		uint64_t data[3] = {};
+		if (::read(m_fds[event], data, sizeof(data)) != sizeof(data))
+			continue;
+
+		// the counter never got scheduled on the PMU
+		if (data[2] == 0)
+			continue;
+
+		// scale multiplexed counters
+		sample.values[event] = (data[2] < data[1]) ? (uint64_t)((double)data[0] * data[1] / data[2]) : data[0];
+		sample.valid[event] = true;
+	}
+#endif
+	return sample;
+}
+
+//##################################################################################################################
+//                                                     FUNCTIONS
+//##################################################################################################################
+
+const char* perfEventName(int event) {
+	return perf_event_names[event];
+}
+
+void printPerfSample(const PerfSample& sample, uint64_t units, std::string unit_name) {
+	bool any = false;
+	for (int event = 0; event < perf_event_count; ++event) {
+		if (!sample.valid[event])
+			continue;
+		any = true;
+		printf("    %-14s %16llu   %10.2f / %s\n", perf_event_names[event], (unsigned long long)sample.values[event],
+			units ? (double)sample.values[event] / units : 0.0, unit_name.c_str());
+	}
+
+	// instructions per cycle
+	if (sample.valid[perf_cycles] && sample.valid[perf_instructions] && sample.values[perf_cycles])
+		printf("    %-14s %16.2f\n", "ipc", (double)sample.values[perf_instructions] / sample.values[perf_cycles]);
+
+	if (!any)
+		printf("    hardware counters not available (perf_event_open not permitted)\n");
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// hardware events read through perf_event_open
+enum { perf_cycles, perf_instructions, perf_l1d_misses, perf_llc_misses, perf_branch_misses, perf_event_count };
+
+// counter values, only the events with valid set could be opened
+struct PerfSample {
+	uint64_t values[perf_event_count] = {};
+	bool valid[perf_event_count] = {};
+};
+
+class PerfCounters {
+
+	// perf event file descriptors, -1 when the event is not permitted or not supported
+	int m_fds[perf_event_count];
+
+public:
+
+	PerfCounters();
+
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	// true if at least one counter could be opened
+	bool available() const;
+
+	void reset();
+
+	void enable();
+
+	void disable();
+
+	// reset & enable
+	void start();
+
+	// read counters, scaled up when the kernel multiplexed them
+	PerfSample read() const;
+};
+
+const char* perfEventName(int event);
+
+// print every valid counter as total and per unit (node, call, ...)
+void printPerfSample(const PerfSample& sample, uint64_t units, std::string unit_name);
@@ -0,0 +1,112 @@
+#include "Scaling.hpp"
+#include "Board.hpp"
+#include "Utility.hpp"
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+//##################################################################################################################
+//                                                     FUNCTIONS
+//##################################################################################################################
+
+std::vector<int> scalingThreadCounts(int max_threads) {
+	std::vector<int> counts;
+	for (int threads = 1; threads < max_threads; threads *= 2)
+		counts.push_back(threads);
+	counts.push_back(max_threads > 0 ? max_threads : 1);
+	return counts;
+}
+
+std::vector<ScalingPoint> runScaling(ScalingWorkload workload, int max_threads, int repetitions) {
+	std::vector<ScalingPoint> points;
+
+	for (int threads : scalingThreadCounts(max_threads)) {
+		ScalingPoint point;
+		point.threads = threads;
+
+		// fastest run, the least disturbed by the rest of the machine
+		for (int rep = 0; rep < repetitions; ++rep) {
+			uint64_t start = get_time_ns();
+			uint64_t nodes = workload(threads);
+			double seconds = (get_time_ns() - start) / 1e9;
+
+			if (rep == 0 || seconds < point.seconds) {
+				point.seconds = seconds;
+				point.nodes = nodes;
+			}
+		}
+
+		point.nps = point.seconds > 0 ? point.nodes / point.seconds : 0;
+		point.nps_per_thread = point.nps / threads;
+
+		// relative to the single thread run
+		double base_seconds = points.empty() ? point.seconds : points.front().seconds;
+		point.speedup = point.seconds > 0 ? base_seconds / point.seconds : 0;
+		point.efficiency = point.speedup / threads;
+
+		points.push_back(point);
+	}
+
+	return points;
+}
+
+void printScaling(const std::vector<ScalingPoint>& points) {
+	printf("\n  %8s %14s %10s %14s %14s %9s %11s\n\n", "threads", "nodes", "seconds", "nps", "nps/thread", "speedup", "efficiency");
+	for (const ScalingPoint& point : points) {
+		printf("  %8d %14llu %10.3f %14.0f %14.0f %9.2f %10.1f%%\n", point.threads, (unsigned long long)point.nodes,
+			point.seconds, point.nps, point.nps_per_thread, point.speedup, point.efficiency * 100);
+	}
+	printf("\n");
+}
+
+bool writeScalingJson(const std::vector<ScalingPoint>& points, const std::string& workload_name, const std::string& path) {
+	std::ofstream out(path);
+	if (!out)
+		return false;
+	out.precision(12);
+
+	out << "{\n";
+	out << "  \"workload\": \"" << workload_name << "\",\n";
+	out << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+	out << "  \"points\": [\n";
+	for (size_t i = 0; i < points.size(); ++i) {
+		const ScalingPoint& point = points[i];
+		out << "    { \"threads\": " << point.threads
+			<< ", \"nodes\": " << point.nodes
+			<< ", \"seconds\": " << point.seconds
+			<< ", \"nps\": " << point.nps
+			<< ", \"nps_per_thread\": " << point.nps_per_thread
+			<< ", \"speedup\": " << point.speedup
+			<< ", \"efficiency\": " << point.efficiency
+			<< " }" << (i + 1 < points.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n";
+	out << "}\n";
+	return true;
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+void scalingTest(std::string fen_str, int depth, int max_threads, std::string json_path) {
+	if (max_threads <= 0)
+		max_threads = std::thread::hardware_concurrency();
+
+	printf("\n     Thread scaling: perft %d, 1 to %d threads\n", depth, max_threads);
+
+	std::vector<ScalingPoint> points = runScaling([&](int threads) {
+		return perftParallel(fen_str, depth, threads);
+	}, max_threads, 3);
+	printScaling(points);
+
+	// every thread count must count the same tree
+	for (const ScalingPoint& point : points)
+		if (point.nodes != points.front().nodes)
+			printf("    WARNING: %d threads counted %llu nodes\n\n", point.threads, (unsigned long long)point.nodes);
+
+	if (writeScalingJson(points, "perft " + std::to_string(depth) + " " + fen_str, json_path))
+		std::cout << "Results written to " << json_path << std::endl;
+	else
+		std::cout << "Could not write " << json_path << std::endl;
+}
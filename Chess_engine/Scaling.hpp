@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+
+// result of the workload at one thread count
+struct ScalingPoint {
+	int threads = 0;
+	uint64_t nodes = 0;
+	double seconds = 0;
+	double nps = 0;
+	double nps_per_thread = 0;
+	// time of 1 thread / time of n threads
+	double speedup = 0;
+	// speedup / threads
+	double efficiency = 0;
+};
+
+// multi threaded workload: runs with the given thread count and returns the nodes it searched
+typedef std::function<uint64_t(int threads)> ScalingWorkload;
+
+// 1, 2, 4, ... up to max_threads (max_threads itself is always included)
+std::vector<int> scalingThreadCounts(int max_threads);
+
+// run the workload at every thread count, keeping the fastest of the repetitions
+std::vector<ScalingPoint> runScaling(ScalingWorkload workload, int max_threads, int repetitions);
+
+void printScaling(const std::vector<ScalingPoint>& points);
+
+bool writeScalingJson(const std::vector<ScalingPoint>& points, const std::string& workload_name, const std::string& path);
+
+void scalingTest(std::string fen_str, int depth, int max_threads, std::string json_path);
@@ -0,0 +1,662 @@
+#include "Search.hpp"
+#include "Evaluation.hpp"
+#include "Utility.hpp"
+#include "MovePicker.hpp"
+#include "Bench.hpp"
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+//##################################################################################################################
+//                                                     SEARCH METHODS
+//##################################################################################################################
+
+Search::Search() {
+	// move lists are allocated once, the search itself never allocates
+	for (auto& list : m_move_lists)
+		list.reserve(max_moves);
+}
+
+void Search::setPosition(const Board& board) {
+	m_board = board;
+
+	// the node count of the last search isn't reported until the thread starts searching
+	m_nodes.store(0, std::memory_order_relaxed);
+}
+
+// mate scores are stored relative to the node, not to the root
+static inline int scoreToTT(int score, int ply) {
+	if (score > mate_score) return score + ply;
+	if (score < -mate_score) return score - ply;
+	return score;
+}
+
+static inline int scoreFromTT(int score, int ply) {
+	if (score > mate_score) return score - ply;
+	if (score < -mate_score) return score + ply;
+	return score;
+}
+
+// mate distance of a tablebase value as the score of a node ply half moves from the root
+static inline int tablebaseScore(int value, int ply) {
+	if (!value) return draw_score;
+	if (value < 128) return mate_value - ply - (2 * value - 1);
+	return -mate_value + ply + 2 * (value - 128);
+}
+
+// helper thread depth skipping: thread id selects a size & phase, the depth is skipped every other size
+const int skip_size[20] = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+const int skip_phase[20] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+void Search::checkStop()
+{
+	// the main thread always completes the first iteration, to have a move
+	if (m_time && m_time->poll(m_thread_id, nodes()) && (m_thread_id > 0 || m_result.depth > 0))
+		m_stopped = true;
+}
+
+// late move reductions [depth][move number], grow with both
+static const struct lmrTable {
+	int reductions[64][64];
+
+	lmrTable() {
+		for (int depth = 0; depth < 64; depth++)
+			for (int moves = 0; moves < 64; moves++)
+				reductions[depth][moves] = (depth && moves) ? (int)(0.75 + std::log(depth) * std::log(moves) / 2.25) : 0;
+	}
+} lmr_table;
+
+// futility margins by remaining depth (frontier, pre-frontier, pre-pre-frontier)
+const int futility_margin[4] = { 0, 200, 350, 500 };
+
+// reverse futility: margin per remaining depth & deepest node it applies to
+const int reverse_futility_margin = 120;
+const int reverse_futility_depth = 6;
+
+// null move: depth it is tried from & verified from
+const int null_move_depth = 3;
+const int null_verification_depth = 10;
+
+// history gravity: the bonus shrinks as the score approaches its bound
+static inline void updateHistory(int& history, int bonus) {
+	history += bonus - history * (bonus < 0 ? -bonus : bonus) / max_history;
+}
+
+int Search::negamax(int alpha, int beta, int depth)
+{
+	HotRegion hot_region(hot_search);
+
+	// init PV length
+	m_pv_length[m_ply] = m_ply;
+
+	// leaf node, resolve the captures (and checks) first
+	if (depth <= 0)
+		return quiescence(alpha, beta);
+
+	countNode();
+
+	// poll the stop signal
+	if ((m_nodes.load(std::memory_order_relaxed) & (poll_interval - 1)) == 0)
+		checkStop();
+	if (m_stopped)
+		return 0;
+
+	// too deep, stop here
+	if (m_ply >= max_ply - 1)
+		return evaluate(m_board, &m_pawn_table);
+
+	bool in_check = m_board.inCheck();
+
+	// draw by repetition or by the fifty move rule (unless this is mate)
+	if (m_ply > 0 && (m_board.isRepetition() || (m_board.fifty() >= 100 && !in_check)))
+		return draw_score;
+
+	// check extension
+	if (in_check)
+		depth++;
+
+	bool pv_node = beta - alpha > 1;
+
+	// mate distance pruning: a shorter mate was already found
+	if (m_options.mate_distance && m_ply > 0) {
+		if (alpha < -mate_value + m_ply)
+			alpha = -mate_value + m_ply;
+		if (beta > mate_value - m_ply - 1)
+			beta = mate_value - m_ply - 1;
+		if (alpha >= beta) {
+			m_pruning_stats.mate_distance_cutoffs++;
+			return alpha;
+		}
+	}
+
+	// exact result of the endgame tables
+	if (m_tablebases && m_ply > 0) {
+		int value;
+		if (m_tablebases->probe(m_board, value)) {
+			m_tablebase_hits++;
+			return tablebaseScore(value, m_ply);
+		}
+	}
+
+	int original_alpha = alpha;
+	int hash_move = 0;
+
+	// transposition table lookup
+	if (m_tt) {
+		TTData tt_data;
+		m_tt_stats.probes++;
+		if (m_tt->probe(m_board.hashKey(), tt_data)) {
+			m_tt_stats.hits++;
+			hash_move = tt_data.move;
+
+			// cut off in non PV nodes when the stored bound is deep enough
+			if (!pv_node && m_ply > 0 && tt_data.depth >= depth) {
+				int tt_score = scoreFromTT(tt_data.score, m_ply);
+				if (tt_data.bound == bound_exact
+					|| (tt_data.bound == bound_lower && tt_score >= beta)
+					|| (tt_data.bound == bound_upper && tt_score <= alpha)) {
+					m_tt_stats.cutoffs++;
+					return tt_score;
+				}
+			}
+		}
+	}
+
+	// static evaluation for the pruning decisions (meaningless in check)
+	int static_eval = in_check ? -infinity : evaluate(m_board, &m_pawn_table, &m_attack_maps[m_ply]);
+	bool can_prune = !pv_node && !in_check && m_ply > 0;
+
+	// reverse futility: far enough above beta for the remaining depth
+	if (m_options.reverse_futility && can_prune && depth <= reverse_futility_depth
+		&& static_eval - reverse_futility_margin * depth >= beta && static_eval < mate_score) {
+		m_pruning_stats.reverse_futility_cutoffs++;
+		return static_eval - reverse_futility_margin * depth;
+	}
+
+	// null move: passing still fails high, a real move surely would (not in zugzwang prone positions:
+	// pawn & king endings, after a null move, or in the verification search)
+	int previous = (m_ply > 0) ? m_move_stack[m_ply - 1] : 0;
+	bool pieces_left = m_board.side() == white
+		? (m_board.bitboards()[N] | m_board.bitboards()[B] | m_board.bitboards()[R] | m_board.bitboards()[Q])
+		: (m_board.bitboards()[n] | m_board.bitboards()[b] | m_board.bitboards()[r] | m_board.bitboards()[q]);
+
+	if (m_options.null_move && can_prune && depth >= null_move_depth && static_eval >= beta && pieces_left
+		&& previous != 0 && !m_null_verification) {
+		int reduction = 3 + depth / 6;
+
+		m_board.copyBoard();
+		m_board.makeNullMove();
+		m_move_stack[m_ply] = 0;
+		m_ply++;
+		int null_score = -negamax(-beta, -beta + 1, depth - 1 - reduction);
+		m_ply--;
+		m_board.takeBack();
+
+		if (m_stopped)
+			return 0;
+
+		if (null_score >= beta) {
+			// mate scores of a null move are not proven
+			if (null_score > mate_score)
+				null_score = beta;
+
+			// deep cutoffs are verified by a reduced search without null moves
+			bool verified = true;
+			if (depth >= null_verification_depth) {
+				m_null_verification = true;
+				verified = negamax(beta - 1, beta, depth - reduction) >= beta;
+				m_null_verification = false;
+			}
+			if (verified) {
+				m_pruning_stats.null_cutoffs++;
+				return null_score;
+			}
+		}
+	}
+
+	// futility: quiet moves can't bring the static evaluation up to alpha near the leaves
+	bool futile = m_options.futility && can_prune && depth <= 3 && static_eval + futility_margin[depth] <= alpha;
+
+	// move of the previous PV at this ply, if the current line still follows it
+	int pv_move = (m_follow_pv && m_ply < m_prev_pv_length) ? m_prev_pv[m_ply] : 0;
+
+	// moves are generated stage by stage, the PV move goes first while following the PV
+	int previous_move = (m_ply > 0) ? m_move_stack[m_ply - 1] : 0;
+	int counter_move = previous_move ? m_counter_moves[get_move_piece(previous_move)][get_move_target(previous_move)] : 0;
+	MovePicker picker(m_board, &m_move_lists[m_ply], pv_move ? compactMove(pv_move) : hash_move, m_killers[m_ply],
+		counter_move, m_history, m_thread_id, in_check ? nullptr : &m_attack_maps[m_ply]);
+
+	int best_score = -infinity;
+	int best_move = 0;
+	int legal_moves = 0;
+	bool follow_pv = m_follow_pv;
+
+	// quiet moves searched before the best one, penalized on a cutoff
+	int quiets_tried[max_moves];
+	int quiet_count = 0;
+
+	while (int move = picker.nextMove())
+	{
+		// preserve board state
+		m_board.copyBoard();
+
+		// skip illegal moves
+		if (!m_board.makeMove(move, all_moves)) {
+			m_board.clearCopy();
+			continue;
+		}
+
+		// the child probes its cluster right away
+		if (m_tt)
+			m_tt->prefetch(m_board.hashKey());
+
+		bool quiet = !get_move_capture(move) && !get_move_promoted(move);
+		bool gives_check = m_board.inCheck();
+		legal_moves++;
+
+		// skip futile quiet moves, the static evaluation plus the margin bounds their score
+		if (futile && quiet && !gives_check && legal_moves > 1) {
+			m_board.takeBack();
+			m_pruning_stats.futility_pruned++;
+			if (static_eval + futility_margin[depth] > best_score)
+				best_score = static_eval + futility_margin[depth];
+			continue;
+		}
+
+		m_move_stack[m_ply] = move;
+		m_ply++;
+		m_follow_pv = follow_pv && move == pv_move;
+
+		int score;
+
+		// principal variation search: full window for the first move, null window for the others
+		if (legal_moves == 1)
+			score = -negamax(-beta, -alpha, depth - 1);
+		else {
+			// late quiet moves are searched shallower first
+			int reduction = 0;
+			if (m_options.late_move_reductions && depth >= 3 && legal_moves > (pv_node ? 3 : 2) && quiet && !in_check && !gives_check) {
+				reduction = lmr_table.reductions[depth < 64 ? depth : 63][legal_moves < 64 ? legal_moves : 63];
+				reduction -= pv_node;
+				if (reduction > depth - 2)
+					reduction = depth - 2;
+				if (reduction < 0)
+					reduction = 0;
+			}
+
+			score = -negamax(-alpha - 1, -alpha, depth - 1 - reduction);
+			if (reduction) {
+				m_pruning_stats.reductions++;
+
+				// the reduced search beat alpha, search at full depth
+				if (score > alpha) {
+					m_pruning_stats.research++;
+					score = -negamax(-alpha - 1, -alpha, depth - 1);
+				}
+			}
+
+			// the move may be better, search it again with the full window
+			if (score > alpha && score < beta)
+				score = -negamax(-beta, -alpha, depth - 1);
+		}
+
+		m_ply--;
+		m_board.takeBack();
+
+		// stopped, the score is meaningless
+		if (m_stopped)
+			return 0;
+
+		if (score > best_score) {
+			best_score = score;
+			best_move = move;
+
+			if (score > alpha) {
+				alpha = score;
+
+				// write PV move & copy the child line
+				m_pv_table[m_ply][m_ply] = move;
+				for (int next_ply = m_ply + 1; next_ply < m_pv_length[m_ply + 1]; next_ply++)
+					m_pv_table[m_ply][next_ply] = m_pv_table[m_ply + 1][next_ply];
+				m_pv_length[m_ply] = m_pv_length[m_ply + 1];
+
+				// fail high
+				if (score >= beta) {
+					if (quiet) {
+						// killers & counter move
+						if (m_killers[m_ply][0] != move) {
+							m_killers[m_ply][1] = m_killers[m_ply][0];
+							m_killers[m_ply][0] = move;
+						}
+						if (previous_move)
+							m_counter_moves[get_move_piece(previous_move)][get_move_target(previous_move)] = move;
+
+						// reward the quiet move that caused the cutoff, penalize the ones that didn't
+						int bonus = (depth * depth < max_history / 16) ? depth * depth * 16 : max_history;
+						updateHistory(m_history[get_move_piece(move)][get_move_target(move)], bonus);
+						for (int index = 0; index < quiet_count; index++)
+							updateHistory(m_history[get_move_piece(quiets_tried[index])][get_move_target(quiets_tried[index])], -bonus);
+					}
+
+					// cutoff statistics
+					m_cutoffs++;
+					if (legal_moves == 1)
+						m_first_move_cutoffs++;
+					break;
+				}
+			}
+		}
+
+		if (quiet && quiet_count < max_moves)
+			quiets_tried[quiet_count++] = move;
+	}
+
+	m_follow_pv = follow_pv;
+
+	// checkmate (prefer the shortest) or stalemate
+	if (legal_moves == 0)
+		best_score = in_check ? -mate_value + m_ply : 0;
+
+	// store the result with its bound
+	if (m_tt) {
+		int bound = (best_score >= beta) ? bound_lower : (best_score > original_alpha) ? bound_exact : bound_upper;
+		m_tt->store(m_board.hashKey(), compactMove(best_move), scoreToTT(best_score, m_ply), depth, bound);
+	}
+
+	return best_score;
+}
+
+int Search::quiescence(int alpha, int beta)
+{
+	HotRegion hot_region(hot_search);
+
+	countNode();
+	m_qnodes++;
+
+	// poll the stop signal
+	if ((m_nodes.load(std::memory_order_relaxed) & (poll_interval - 1)) == 0)
+		checkStop();
+	if (m_stopped)
+		return 0;
+
+	// too deep, stop here
+	if (m_ply >= max_ply - 1)
+		return evaluate(m_board, &m_pawn_table);
+
+	// in check every evasion is searched, standing pat is not an option
+	bool in_check = m_board.inCheck();
+	int stand_pat = -infinity;
+	int best_score = -infinity;
+
+	if (!in_check) {
+		// stand pat: the side to move can usually do at least as well as the static evaluation
+		stand_pat = evaluate(m_board, &m_pawn_table);
+		if (stand_pat >= beta)
+			return stand_pat;
+		if (stand_pat > alpha)
+			alpha = stand_pat;
+		best_score = stand_pat;
+	}
+
+	// captures only, every evasion when in check
+	MovePicker picker = in_check
+		? MovePicker(m_board, &m_move_lists[m_ply], 0, nullptr, 0, m_history, m_thread_id)
+		: MovePicker(m_board, &m_move_lists[m_ply], 0);
+
+	int legal_moves = 0;
+
+	while (int move = picker.nextMove())
+	{
+		// delta pruning: winning the victim (plus a margin) still leaves the score below alpha
+		if (!in_check && !get_move_promoted(move)
+			&& stand_pat + material_score[get_move_enpassant(move) ? P : m_board.pieceOn(get_move_target(move)) % 6] + delta_margin <= alpha) {
+			m_delta_pruned++;
+			continue;
+		}
+
+		// preserve board state
+		m_board.copyBoard();
+
+		// skip illegal moves
+		if (!m_board.makeMove(move, in_check ? all_moves : only_captures)) {
+			m_board.clearCopy();
+			continue;
+		}
+
+		m_ply++;
+		legal_moves++;
+		int score = -quiescence(-beta, -alpha);
+		m_ply--;
+		m_board.takeBack();
+
+		// stopped, the score is meaningless
+		if (m_stopped)
+			return 0;
+
+		if (score > best_score) {
+			best_score = score;
+			if (score > alpha) {
+				alpha = score;
+
+				// fail high
+				if (score >= beta)
+					break;
+			}
+		}
+	}
+
+	// checkmate
+	if (in_check && legal_moves == 0)
+		return -mate_value + m_ply;
+
+	return best_score;
+}
+
+SearchResult Search::searchPosition(int max_depth, bool verbose)
+{
+	SearchResult result;
+
+	m_nodes.store(0, std::memory_order_relaxed);
+	m_stopped = false;
+	m_result = SearchResult();
+	memset(m_history, 0, sizeof(m_history));
+	m_ply = 0;
+	m_prev_pv_length = 0;
+	m_tt_stats = TTStats();
+	m_qnodes = 0;
+	m_delta_pruned = 0;
+	m_tablebase_hits = 0;
+	m_cutoffs = 0;
+	m_first_move_cutoffs = 0;
+	m_pruning_stats = PruningStats();
+	m_null_verification = false;
+	memset(m_killers, 0, sizeof(m_killers));
+	memset(m_counter_moves, 0, sizeof(m_counter_moves));
+
+	// a coordinated search leaves aging the table & the bestmove to its coordinator
+	if (m_tt && !m_coordinated)
+		m_tt->newSearch();
+
+	// depth limit of the time manager
+	if (m_time && m_time->depthLimit() && m_time->depthLimit() < max_depth)
+		max_depth = m_time->depthLimit();
+
+	uint64_t start = get_time_ms();
+
+	// iterative deepening
+	for (int depth = 1; depth <= max_depth && depth < max_ply; depth++)
+	{
+		// helper threads skip some depths so the threads spread over several depths
+		if (m_thread_id > 0 && depth > 1) {
+			int index = (m_thread_id - 1) % 20;
+			if (((depth + skip_phase[index]) / skip_size[index]) % 2)
+				continue;
+		}
+
+		m_follow_pv = true;
+		int score = negamax(-infinity, infinity, depth);
+
+		// unfinished iteration, keep the previous result
+		if (m_stopped)
+			break;
+
+		// keep this iteration PV for the next one
+		m_prev_pv_length = m_pv_length[0];
+		for (int ply = 0; ply < m_prev_pv_length; ply++)
+			m_prev_pv[ply] = m_pv_table[0][ply];
+
+		result.depth = depth;
+		result.score = score;
+		result.nodes = nodes();
+		result.time_ms = get_time_ms() - start;
+		if (m_pv_length[0] > 0)
+			result.best_move = m_pv_table[0][0];
+		m_result = result;
+
+		if (verbose) {
+			uint64_t reported_nodes = m_report_nodes ? m_report_nodes() : result.nodes;
+			uint64_t nps = reported_nodes * 1000 / (result.time_ms ? result.time_ms : 1);
+			// one write per line, other threads (the UCI input) print in between
+			std::string pv;
+			for (int ply = 0; ply < m_pv_length[0]; ply++)
+				pv += " " + moveToString(m_pv_table[0][ply]);
+			printf("info depth %d score %s nodes %llu nps %llu time %llu pv%s\n", depth, scoreToString(score).c_str(),
+				(unsigned long long)reported_nodes, (unsigned long long)nps, (unsigned long long)result.time_ms, pv.c_str());
+		}
+
+		// no need to search deeper than a found mate
+		if (score > mate_score || score < -mate_score)
+			if (mate_value - (score > 0 ? score : -score) <= depth)
+				break;
+
+		// not enough time left for another iteration (the main thread decides)
+		if (m_time && m_thread_id == 0 && m_time->softExpired())
+			break;
+	}
+
+	if (verbose && m_tt) {
+		printf("info string tt probes %llu hits %llu (%.1f%%) cutoffs %llu hashfull %d\n",
+			(unsigned long long)m_tt_stats.probes, (unsigned long long)m_tt_stats.hits,
+			m_tt_stats.probes ? 100.0 * m_tt_stats.hits / m_tt_stats.probes : 0.0,
+			(unsigned long long)m_tt_stats.cutoffs, m_tt->hashfull());
+	}
+
+	if (verbose) {
+		printf("info string qsearch nodes %llu (%.1f%%) delta pruned %llu\n", (unsigned long long)m_qnodes,
+			nodes() ? 100.0 * m_qnodes / nodes() : 0.0, (unsigned long long)m_delta_pruned);
+		printf("info string beta cutoffs %llu first move %.1f%%\n", (unsigned long long)m_cutoffs,
+			m_cutoffs ? 100.0 * m_first_move_cutoffs / m_cutoffs : 0.0);
+		if (m_tablebases)
+			printf("info string tablebase hits %llu\n", (unsigned long long)m_tablebase_hits);
+		printf("info string null cutoffs %llu reductions %llu (researched %llu) futility pruned %llu reverse futility %llu mate distance %llu\n",
+			(unsigned long long)m_pruning_stats.null_cutoffs, (unsigned long long)m_pruning_stats.reductions,
+			(unsigned long long)m_pruning_stats.research, (unsigned long long)m_pruning_stats.futility_pruned,
+			(unsigned long long)m_pruning_stats.reverse_futility_cutoffs, (unsigned long long)m_pruning_stats.mate_distance_cutoffs);
+	}
+
+	result.nodes = nodes();
+	m_result.nodes = result.nodes;
+
+	if (verbose && result.best_move && !m_coordinated)
+		printf("bestmove %s\n", moveToString(result.best_move).c_str());
+
+	return result;
+}
+
+//##################################################################################################################
+//                                                     FUNCTIONS
+//##################################################################################################################
+
+std::string scoreToString(int score)
+{
+	// mate in moves, negative when getting mated
+	if (score > mate_score)
+		return "mate " + std::to_string((mate_value - score + 1) / 2);
+	if (score < -mate_score)
+		return "mate " + std::to_string(-(mate_value + score) / 2);
+
+	return "cp " + std::to_string(score);
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+void searchTest()
+{
+	Board b;
+	TranspositionTable tt(16);
+	Search search;
+	search.setTranspositionTable(&tt);
+
+	// back rank mate in one
+	b.parse_fen("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1 ");
+	b.plot();
+	search.setPosition(b);
+	search.searchPosition(4);
+
+	b.parse_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 ");
+	b.plot();
+	search.setPosition(b);
+	search.searchPosition(5);
+}
+
+void pruningTest(int depth)
+{
+	struct pruningCase { const char* name; SearchOptions options; };
+
+	SearchOptions null_move = SearchOptions::none(), lmr = SearchOptions::none(), futility = SearchOptions::none(),
+		reverse_futility = SearchOptions::none(), mate_distance = SearchOptions::none();
+	null_move.null_move = true;
+	lmr.late_move_reductions = true;
+	futility.futility = true;
+	reverse_futility.reverse_futility = true;
+	mate_distance.mate_distance = true;
+
+	const pruningCase cases[] = {
+		{ "none", SearchOptions::none() },
+		{ "null move", null_move },
+		{ "late move reductions", lmr },
+		{ "futility", futility },
+		{ "reverse futility", reverse_futility },
+		{ "mate distance", mate_distance },
+		{ "all", SearchOptions() },
+	};
+
+	TranspositionTable tt(16);
+	Search search;
+	search.setTranspositionTable(&tt);
+	Board b;
+
+	printf("\n     Pruning techniques: depth %d on %d positions\n", depth, (int)benchPositions().size());
+	printf("\n  %-22s %14s %10s %10s %10s\n\n", "technique", "nodes", "time ms", "nodes %", "same move");
+
+	uint64_t base_nodes = 0;
+	std::vector<int> base_moves;
+
+	for (const pruningCase& test : cases) {
+		uint64_t nodes = 0, time_ms = 0;
+		int same_moves = 0;
+		search.setOptions(test.options);
+
+		for (size_t index = 0; index < benchPositions().size(); index++) {
+			// every position starts from an empty table
+			tt.clear();
+			b.parse_fen(benchPositions()[index].fen);
+			search.setPosition(b);
+			SearchResult result = search.searchPosition(depth, false);
+
+			nodes += result.nodes;
+			time_ms += result.time_ms;
+			if (base_moves.size() < benchPositions().size())
+				base_moves.push_back(result.best_move);
+			same_moves += (result.best_move == base_moves[index]);
+		}
+
+		if (!base_nodes)
+			base_nodes = nodes;
+		printf("  %-22s %14llu %10llu %9.1f%% %6d/%d\n", test.name, (unsigned long long)nodes, (unsigned long long)time_ms,
+			base_nodes ? 100.0 * nodes / base_nodes : 0.0, same_moves, (int)benchPositions().size());
+	}
+	printf("\n");
+}
@@ -0,0 +1,202 @@
+#pragma once
+#include "Board.hpp"
+#include "TranspositionTable.hpp"
+#include "TimeManager.hpp"
+#include "Pawns.hpp"
+#include "AttackMaps.hpp"
+#include "Tablebase.hpp"
+#include <cstdint>
+#include <string>
+#include <atomic>
+#include <functional>
+
+// maximum search depth in plies
+const int max_ply = 128;
+
+// score bounds, stored in the 16 bit score of a transposition table entry
+const int infinity = 32000;
+const int mate_value = 31000;
+
+// scores beyond mate_score are mates
+const int mate_score = 30000;
+static_assert(infinity <= INT16_MAX, "scores have to fit the transposition table entries");
+
+// repetitions & the fifty move rule
+const int draw_score = 0;
+
+// result of the last completed iteration
+struct SearchResult {
+	int best_move = 0;
+	int score = 0;
+	int depth = 0;
+	uint64_t nodes = 0;
+	uint64_t time_ms = 0;
+};
+
+// quiescence search: a capture can't raise alpha when even its victim plus this margin doesn't
+const int delta_margin = 200;
+
+// pruning & reduction techniques, each can be switched off
+struct SearchOptions {
+	bool null_move = true;
+	bool late_move_reductions = true;
+	bool futility = true;
+	bool reverse_futility = true;
+	bool mate_distance = true;
+
+	// plain alpha-beta (with quiescence & transposition table)
+	static SearchOptions none() { return SearchOptions{ false, false, false, false, false }; }
+};
+
+// nodes cut or moves skipped by each technique
+struct PruningStats {
+	uint64_t null_cutoffs = 0;
+	uint64_t reductions = 0;
+	uint64_t research = 0;
+	uint64_t futility_pruned = 0;
+	uint64_t reverse_futility_cutoffs = 0;
+	uint64_t mate_distance_cutoffs = 0;
+};
+
+// transposition table usage of a search
+struct TTStats {
+	uint64_t probes = 0;
+	uint64_t hits = 0;
+	uint64_t cutoffs = 0;
+};
+
+class Search {
+
+	// own copy of the position, searched with copyBoard/makeMove/takeBack
+	Board m_board;
+
+	// half moves from the root
+	int m_ply = 0;
+
+	// visited nodes, only written by the searching thread (relaxed, no contention) but readable by others
+	std::atomic<uint64_t> m_nodes{ 0 };
+
+	// 0 for the main thread, helpers perturb depths & move ordering by their id
+	int m_thread_id = 0;
+
+	// limits & stop signal (optional), polled every poll_interval nodes
+	TimeManager* m_time = nullptr;
+	bool m_stopped = false;
+
+	// run by a coordinator (lazy SMP) that ages the table & reports the best move
+	bool m_coordinated = false;
+
+	// nodes reported in the info lines (all threads for a parallel search)
+	std::function<uint64_t()> m_report_nodes;
+
+	// quiet move history [piece][target square], per thread
+	int m_history[12][64] = {};
+
+	// two quiet moves that cut off at each ply
+	int m_killers[max_ply][2] = {};
+
+	// quiet move that refuted a move [piece][target square]
+	int m_counter_moves[12][64] = {};
+
+	// move made at each ply
+	int m_move_stack[max_ply] = {};
+
+	SearchOptions m_options;
+	PruningStats m_pruning_stats;
+
+	// no null move in the verification search of a null move cutoff
+	bool m_null_verification = false;
+
+	// beta cutoffs & the ones by the first move (ordering quality)
+	uint64_t m_cutoffs = 0;
+	uint64_t m_first_move_cutoffs = 0;
+
+	// last completed iteration
+	SearchResult m_result;
+
+	// triangular PV table, row ply holds the best line from ply on
+	int m_pv_length[max_ply] = {};
+	int m_pv_table[max_ply][max_ply] = {};
+
+	// PV of the previous iteration, searched first while the current line follows it
+	int m_prev_pv[max_ply] = {};
+	int m_prev_pv_length = 0;
+	bool m_follow_pv = false;
+
+	// one preallocated move list per ply
+	std::vector<uint64_t> m_move_lists[max_ply];
+
+	// shared transposition table (optional) & its counters for this search
+	TranspositionTable* m_tt = nullptr;
+	TTStats m_tt_stats;
+
+	// pawn structure cache, per thread
+	PawnTable m_pawn_table;
+
+	// attack maps built by the static evaluation of each ply, reused to order the quiet moves
+	AttackMaps m_attack_maps[max_ply];
+
+	int negamax(int alpha, int beta, int depth);
+
+	// captures & promotions only until the position is quiet
+	int quiescence(int alpha, int beta);
+
+	// quiescence nodes & captures skipped by delta pruning
+	uint64_t m_qnodes = 0;
+	uint64_t m_delta_pruned = 0;
+
+	// endgame tables (optional, shared & read only) & the nodes they resolved
+	const Tablebases* m_tablebases = nullptr;
+	uint64_t m_tablebase_hits = 0;
+
+	void countNode() { m_nodes.store(m_nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+	// poll the limits & the stop signal
+	void checkStop();
+
+
+public:
+
+	Search();
+
+	void setPosition(const Board& board);
+
+	void setTranspositionTable(TranspositionTable* tt) { m_tt = tt; }
+
+	void setTablebases(const Tablebases* tablebases) { m_tablebases = tablebases; }
+
+	void setThreadId(int thread_id) { m_thread_id = thread_id; }
+
+	void setOptions(const SearchOptions& options) { m_options = options; }
+
+	void setTimeManager(TimeManager* time) { m_time = time; }
+
+	void setCoordinated(bool coordinated) { m_coordinated = coordinated; }
+
+	void setNodeReporter(std::function<uint64_t()> report_nodes) { m_report_nodes = report_nodes; }
+
+	// iterative deepening up to max_depth (or the limits of the time manager), printing one info line per iteration when verbose
+	SearchResult searchPosition(int max_depth, bool verbose = true);
+
+	uint64_t nodes() const { return m_nodes.load(std::memory_order_relaxed); }
+
+	const SearchResult& lastResult() const { return m_result; }
+
+	const TTStats& ttStats() const { return m_tt_stats; }
+
+	const PruningStats& pruningStats() const { return m_pruning_stats; }
+
+	const PawnTable& pawnTable() const { return m_pawn_table; }
+
+	// principal variation of the last iteration
+	int pvLength() const { return m_pv_length[0]; }
+	const int* pv() const { return m_pv_table[0]; }
+};
+
+// UCI score string (cp x / mate y)
+std::string scoreToString(int score);
+
+void searchTest();
+
+// nodes & time to depth of each pruning technique on the bench positions
+void pruningTest(int depth);
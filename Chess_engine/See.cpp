@@ -0,0 +1,182 @@
+#include "See.hpp"
+#include <cstdio>
+
+//##################################################################################################################
+//                                                     FUNCTIONS
+//##################################################################################################################
+
+// least valuable attacker of side among attackers, its piece in piece (-1 if none)
+static inline uint64_t leastValuableAttacker(const Board& board, uint64_t attackers, int side, int& piece) {
+	int first = (side == white) ? P : p;
+	for (piece = first; piece <= first + K; piece++) {
+		uint64_t subset = attackers & board.bitboards()[piece];
+		if (subset)
+			return subset & (~subset + 1);
+	}
+	piece = -1;
+	return 0;
+}
+
+// sliders seen through the squares left by the captures
+static inline uint64_t xrayAttackers(const Board& board, int square, uint64_t occupancy) {
+	return board.attackersTo(square, occupancy) & occupancy;
+}
+
+int see(const Board& board, int move) {
+	int source_square = get_move_source(move);
+	int target_square = get_move_target(move);
+	int promoted_piece = get_move_promoted(move);
+
+	if (get_move_castling(move))
+		return 0;
+
+	// gain[depth]: material won by the capture at depth if the exchange stopped there
+	int gain[32];
+	int depth = 0;
+
+	int victim = get_move_enpassant(move) ? P : board.pieceOn(target_square);
+	gain[0] = (victim >= 0) ? see_value[victim % 6] : 0;
+
+	// the piece standing on the target square after the move
+	int attacker_value = see_value[get_move_piece(move) % 6];
+	if (promoted_piece) {
+		gain[0] += see_value[promoted_piece % 6] - see_value[P];
+		attacker_value = see_value[promoted_piece % 6];
+	}
+
+	uint64_t occupancy = board.occupancies()[both] ^ (1ULL << source_square);
+	if (get_move_enpassant(move))
+		occupancy ^= 1ULL << (target_square + ((board.side() == white) ? 8 : -8));
+
+	uint64_t attackers = xrayAttackers(board, target_square, occupancy);
+	int side = board.side() ^ 1;
+
+	while (depth < 31) {
+		int piece;
+		uint64_t from = leastValuableAttacker(board, attackers & board.occupancies()[side], side, piece);
+		if (!from)
+			break;
+
+		// capture the last attacker
+		depth++;
+		gain[depth] = attacker_value - gain[depth - 1];
+
+		// remove the attacker, the sliders behind it join in
+		occupancy ^= from;
+		attackers = xrayAttackers(board, target_square, occupancy);
+		attacker_value = see_value[piece % 6];
+		side ^= 1;
+	}
+
+	// each side stops capturing when going on is worse
+	while (depth > 0) {
+		depth--;
+		gain[depth] = -((-gain[depth] > gain[depth + 1]) ? -gain[depth] : gain[depth + 1]);
+	}
+	return gain[0];
+}
+
+bool seeGe(const Board& board, int move, int threshold) {
+	if (get_move_castling(move) || get_move_promoted(move))
+		return see(board, move) >= threshold;
+
+	int source_square = get_move_source(move);
+	int target_square = get_move_target(move);
+
+	int victim = get_move_enpassant(move) ? P : board.pieceOn(target_square);
+
+	// even winning the victim for free doesn't reach the threshold
+	int swap = ((victim >= 0) ? see_value[victim % 6] : 0) - threshold;
+	if (swap < 0)
+		return false;
+
+	// even losing the moving piece still reaches it
+	swap = see_value[get_move_piece(move) % 6] - swap;
+	if (swap <= 0)
+		return true;
+
+	uint64_t occupancy = board.occupancies()[both] ^ (1ULL << source_square) ^ (1ULL << target_square);
+	if (get_move_enpassant(move))
+		occupancy ^= 1ULL << (target_square + ((board.side() == white) ? 8 : -8));
+
+	uint64_t attackers = xrayAttackers(board, target_square, occupancy);
+	int side = board.side();
+
+	// result if the side to move (of the exchange) has no attacker left
+	bool result = true;
+
+	while (true) {
+		side ^= 1;
+		attackers &= occupancy;
+
+		int piece;
+		uint64_t from = leastValuableAttacker(board, attackers & board.occupancies()[side], side, piece);
+		if (!from)
+			break;
+
+		result = !result;
+
+		// a king can't capture into a defended square
+		if (piece % 6 == K)
+			return (attackers & board.occupancies()[side ^ 1]) ? !result : result;
+
+		// the balance stays on the same side of the threshold whatever follows
+		swap = see_value[piece % 6] - swap;
+		if (swap < (int)result)
+			break;
+
+		occupancy ^= from;
+		attackers = xrayAttackers(board, target_square, occupancy);
+	}
+	return result;
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+void seeTest() {
+	struct seeCase { const char* fen; int source, target; int expected; };
+
+	// a8 = 0 ... h1 = 63
+	const seeCase cases[] = {
+		// Rxe5, undefended pawn
+		{ "1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - ", 60, 28, 100 },
+		// Nxe5, the pawn is defended & the queen behind the rook x-rays e5
+		{ "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - ", 43, 28, -220 },
+		// Qxd5 into a pawn defence
+		{ "4k3/8/4p3/3p4/8/8/8/3QK3 w - - ", 59, 27, -800 },
+		// Rxd5, rooks doubled on the d file against a single defender
+		{ "3rk3/8/8/3p4/8/8/3R4/3RK3 w - - ", 51, 27, 100 },
+		// Bxf7, the king recaptures
+		{ "4k3/5p2/8/8/2B5/8/8/4K3 w - - ", 34, 13, -230 },
+	};
+
+	Board b;
+	std::vector<uint64_t> move_list;
+	int failures = 0;
+
+	printf("\n    move    see  expected  seeGe(0)  seeGe(see)  seeGe(see+1)\n\n");
+	for (const seeCase& test : cases) {
+		b.parse_fen(test.fen);
+		move_list.clear();
+		b.generateMoves(&move_list);
+
+		for (uint64_t move : move_list) {
+			if ((int)get_move_source(move) != test.source || (int)get_move_target(move) != test.target)
+				continue;
+
+			int value = see(b, (int)move);
+			bool ge_zero = seeGe(b, (int)move, 0);
+			bool ge_value = seeGe(b, (int)move, value);
+			bool ge_above = seeGe(b, (int)move, value + 1);
+			printf("    %s  %5d  %8d  %8d  %10d  %12d\n", moveToString((int)move).c_str(), value, test.expected, ge_zero, ge_value, ge_above);
+
+			if (value != test.expected || ge_zero != (value >= 0) || !ge_value || ge_above)
+				failures++;
+		}
+	}
+
+	// calls per second are measured by the see benchmark of the bench harness
+	printf("\n    Failures : %d\n", failures);
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "Board.hpp"
+
+// exchange values [piece % 6], the king can't be captured
+const int see_value[6] = { 100, 320, 330, 500, 900, 20000 };
+
+/*
+		Static exchange evaluation
+
+	Material balance of the capture sequence on the target square of a move when
+	both sides always recapture with their least valuable attacker and may stop
+	capturing whenever that is better for them. Sliders behind a capturing piece
+	join the exchange (x-rays) as the occupancy shrinks. Pins are ignored.
+*/
+
+// swap-off value of the move (0 for quiet moves that can't be captured back)
+int see(const Board& board, int move);
+
+// see(move) >= threshold, usually without playing out the whole exchange
+bool seeGe(const Board& board, int move, int threshold);
+
+void seeTest();
@@ -0,0 +1,944 @@
+#include "Tablebase.hpp"
+#include "Bitbase.hpp"
+#include "Evaluation.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+//##################################################################################################################
+//                                                     VARIABLES
+//##################################################################################################################
+
+const uint32_t tablebase_version = 1;
+
+// file header, followed by blocks + 1 offsets (from the first block) & the blocks
+struct TablebaseHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t signature;
+	uint32_t blocks;
+	uint64_t size;
+};
+
+const uint64_t no_index = ~0ULL;
+
+// piece letters in index order (queens first, pawns last) & the piece types they stand for
+const char piece_letters[] = "QRBNP";
+const int letter_pieces[5] = { Q, R, B, N, P };
+
+// binomial coefficients [n][k], index of a combination of k squares out of n
+static std::array<std::array<uint64_t, max_tablebase_men + 1>, 65> initBinomials() {
+	std::array<std::array<uint64_t, max_tablebase_men + 1>, 65> binomials = {};
+	for (int n = 0; n <= 64; n++) {
+		binomials[n][0] = 1;
+		for (int k = 1; k <= max_tablebase_men && k <= n; k++)
+			binomials[n][k] = binomials[n - 1][k - 1] + ((k <= n - 1) ? binomials[n - 1][k] : 0);
+	}
+	return binomials;
+}
+
+const std::array<std::array<uint64_t, max_tablebase_men + 1>, 65> binomial = initBinomials();
+
+// king pair index [pawns][white king][black king] (-1: adjacent kings or outside the region) & the squares of each index
+struct kingPairs {
+	int16_t index[2][64][64];
+	uint8_t white_king[2][64 * 64];
+	uint8_t black_king[2][64 * 64];
+	int count[2];
+};
+
+static kingPairs initKingPairs() {
+	kingPairs pairs;
+	for (int pawns = 0; pawns <= 1; pawns++) {
+		pairs.count[pawns] = 0;
+		for (int white_king = 0; white_king < 64; white_king++) {
+			for (int black_king = 0; black_king < 64; black_king++) {
+				int file = white_king % 8, rank = 7 - white_king / 8;
+				int black_file = black_king % 8, black_rank = 7 - black_king / 8;
+				bool region = pawns ? file <= 3 : (file <= 3 && rank <= file && (rank != file || black_rank <= black_file));
+				bool apart = std::abs(file - black_file) > 1 || std::abs(rank - black_rank) > 1;
+
+				pairs.index[pawns][white_king][black_king] = -1;
+				if (!region || !apart)
+					continue;
+				pairs.white_king[pawns][pairs.count[pawns]] = (uint8_t)white_king;
+				pairs.black_king[pawns][pairs.count[pawns]] = (uint8_t)black_king;
+				pairs.index[pawns][white_king][black_king] = (int16_t)pairs.count[pawns]++;
+			}
+		}
+	}
+	return pairs;
+}
+
+const kingPairs king_pairs = initKingPairs();
+
+//##################################################################################################################
+//                                                     MATERIAL METHODS
+//##################################################################################################################
+
+// slot of piece in the signature (kings have none)
+static inline int signatureSlot(int piece) {
+	return (piece < 6) ? piece : piece - 1;
+}
+
+static inline uint32_t flipSignature(uint32_t signature) {
+	return (signature >> 15) | ((signature & 0x7fff) << 15);
+}
+
+// the stronger side plays white & the layout of the index
+static void setupMaterial(TablebaseMaterial& material) {
+	int value[2] = {}, half[2] = {};
+	for (int side = white; side <= black; side++)
+		for (int type = P; type <= Q; type++) {
+			value[side] += material.count[side * 6 + type] * material_score[type];
+			half[side] |= material.count[side * 6 + type] << (3 * type);
+		}
+	if (value[black] > value[white] || (value[black] == value[white] && half[black] > half[white]))
+		for (int type = P; type <= K; type++)
+			std::swap(material.count[type], material.count[type + 6]);
+
+	material.men = 0;
+	material.signature = 0;
+	for (int piece = P; piece <= k; piece++) {
+		material.men += material.count[piece];
+		if (piece % 6 != K)
+			material.signature |= material.count[piece] << (3 * signatureSlot(piece));
+	}
+	material.pawns = material.count[P] || material.count[p];
+
+	material.groups = 0;
+	material.size = king_pairs.count[material.pawns];
+	for (int side = white; side <= black; side++)
+		for (int letter = 0; letter < 5; letter++) {
+			int piece = side * 6 + letter_pieces[letter];
+			if (!material.count[piece])
+				continue;
+			material.group_piece[material.groups] = piece;
+			material.group_count[material.groups] = material.count[piece];
+			material.group_size[material.groups] = binomial[(piece % 6 == P) ? 48 : 64][material.count[piece]];
+			material.size *= material.group_size[material.groups++];
+		}
+}
+
+bool TablebaseMaterial::parse(const std::string& name) {
+	size_t separator = name.find('v');
+	if (separator == std::string::npos)
+		return false;
+
+	std::memset(count, 0, sizeof(count));
+	for (size_t i = 0; i < name.size(); i++) {
+		if (i == separator)
+			continue;
+		int side = (i < separator) ? white : black;
+		const char* letter = std::strchr(piece_letters, name[i]);
+		if (name[i] == 'K')
+			count[side * 6 + K]++;
+		else if (letter && name[i])
+			count[side * 6 + letter_pieces[letter - piece_letters]]++;
+		else
+			return false;
+	}
+	if (count[K] != 1 || count[k] != 1)
+		return false;
+
+	setupMaterial(*this);
+	return men <= max_tablebase_men;
+}
+
+std::string TablebaseMaterial::name() const {
+	std::string name;
+	for (int side = white; side <= black; side++) {
+		name += (side == white) ? "K" : "vK";
+		for (int letter = 0; letter < 5; letter++)
+			name.append(count[side * 6 + letter_pieces[letter]], piece_letters[letter]);
+	}
+	return name;
+}
+
+//##################################################################################################################
+//                                                     FUNCTIONS
+//##################################################################################################################
+
+// symmetry of the board: bit 0 mirrors the files, bit 1 the ranks, bit 2 reflects on the a1-h8 diagonal
+static inline int transformSquare(int square, int transform) {
+	if (transform & 4)
+		square = (7 - square % 8) * 8 + (7 - square / 8);
+	if (transform & 1)
+		square ^= 7;
+	if (transform & 2)
+		square ^= 56;
+	return square;
+}
+
+// index of the position seen through a symmetry, no_index when the kings fall outside the region
+static uint64_t indexWith(const TablebaseMaterial& material, const TablebasePosition& position, int transform)
+{
+	int squares[12][max_tablebase_men];
+	int found[12] = {};
+	for (int i = 0; i < position.count; i++)
+		squares[position.piece[i]][found[position.piece[i]]++] = transformSquare(position.square[i], transform);
+
+	int king_pair = king_pairs.index[material.pawns][squares[K][0]][squares[k][0]];
+	if (king_pair < 0)
+		return no_index;
+
+	uint64_t index = king_pair;
+	for (int group = 0; group < material.groups; group++) {
+		int piece = material.group_piece[group];
+		int* group_squares = squares[piece];
+		std::sort(group_squares, group_squares + found[piece]);
+
+		// combination of the squares (pawns on ranks 2-7 only)
+		uint64_t combination = 0;
+		for (int i = 0; i < found[piece]; i++)
+			combination += binomial[group_squares[i] - ((piece % 6 == P) ? 8 : 0)][i + 1];
+		index = index * material.group_size[group] + combination;
+	}
+	return index;
+}
+
+// smallest index over the symmetries of the material (files only with pawns)
+static uint64_t positionIndex(const TablebaseMaterial& material, const TablebasePosition& position)
+{
+	uint64_t best = no_index;
+	for (int transform = 0; transform < (material.pawns ? 2 : 8); transform++)
+		best = std::min(best, indexWith(material, position, transform));
+	return best;
+}
+
+// position of an index, false when pieces share a square
+static bool decodeIndex(const TablebaseMaterial& material, uint64_t index, int side, TablebasePosition& position)
+{
+	position.count = 0;
+	position.side = side;
+	uint64_t occupancy = 0;
+	bool overlap = false;
+
+	for (int group = material.groups - 1; group >= 0; group--) {
+		int piece = material.group_piece[group];
+		int offset = (piece % 6 == P) ? 8 : 0;
+		int limit = (piece % 6 == P) ? 48 : 64;
+		uint64_t combination = index % material.group_size[group];
+		index /= material.group_size[group];
+
+		for (int i = material.group_count[group]; i >= 1; i--) {
+			int square = i - 1;
+			while (square + 1 < limit && binomial[square + 1][i] <= combination)
+				square++;
+			combination -= binomial[square][i];
+
+			overlap |= (occupancy & (1ULL << (square + offset))) != 0;
+			occupancy |= 1ULL << (square + offset);
+			position.piece[position.count] = piece;
+			position.square[position.count++] = square + offset;
+		}
+	}
+
+	for (int king = K; king <= k; king += 6) {
+		int square = (king == K) ? king_pairs.white_king[material.pawns][index] : king_pairs.black_king[material.pawns][index];
+		overlap |= (occupancy & (1ULL << square)) != 0;
+		occupancy |= 1ULL << square;
+		position.piece[position.count] = king;
+		position.square[position.count++] = square;
+	}
+	return !overlap;
+}
+
+static uint64_t pieceAttacks(const Moves& moves, int piece, int square, uint64_t occupancy)
+{
+	switch (piece % 6) {
+	case P: return moves.getPawnAttacks(piece / 6, square);
+	case N: return moves.getKnightAttacks(square);
+	case B: return moves.getBishopAttacks(square, occupancy);
+	case R: return moves.getRookAttacks(square, occupancy);
+	case Q: return moves.getQueenAttacks(square, occupancy);
+	default: return moves.getKingAttacks(square);
+	}
+}
+
+static uint64_t occupancyOf(const TablebasePosition& position, int side)
+{
+	uint64_t occupancy = 0;
+	for (int i = 0; i < position.count; i++)
+		if (side == both || position.piece[i] / 6 == side)
+			occupancy |= 1ULL << position.square[i];
+	return occupancy;
+}
+
+// king of side is attacked by the other side
+static bool kingAttacked(const Moves& moves, const TablebasePosition& position, int side)
+{
+	uint64_t occupancy = occupancyOf(position, both);
+	int king = 0;
+	for (int i = 0; i < position.count; i++)
+		if (position.piece[i] == side * 6 + K)
+			king = position.square[i];
+
+	for (int i = 0; i < position.count; i++)
+		if (position.piece[i] / 6 != side && (pieceAttacks(moves, position.piece[i], position.square[i], occupancy) & (1ULL << king)))
+			return true;
+	return false;
+}
+
+// legal moves of the side to move, converting: a capture or a promotion (the position belongs to another material)
+static int generateSuccessors(const Moves& moves, const TablebasePosition& position, TablebasePosition* successors, bool* converting)
+{
+	const int promotions[4] = { Q, R, B, N };
+	int side = position.side;
+	uint64_t own = occupancyOf(position, side);
+	uint64_t enemy = occupancyOf(position, side ^ 1);
+	int count = 0;
+
+	for (int i = 0; i < position.count; i++) {
+		int piece = position.piece[i];
+		if (piece / 6 != side)
+			continue;
+		int from = position.square[i];
+
+		uint64_t targets;
+		if (piece % 6 == P) {
+			int push = (side == white) ? -8 : 8;
+			targets = moves.getPawnAttacks(side, from) & enemy;
+			if (!((own | enemy) & (1ULL << (from + push)))) {
+				targets |= 1ULL << (from + push);
+				if (from / 8 == ((side == white) ? 6 : 1) && !((own | enemy) & (1ULL << (from + 2 * push))))
+					targets |= 1ULL << (from + 2 * push);
+			}
+		}
+		else
+			targets = pieceAttacks(moves, piece, from, own | enemy) & ~own;
+
+		while (targets) {
+			int to = get_ls1b_index(targets);
+			targets &= targets - 1;
+			bool capture = (enemy & (1ULL << to)) != 0;
+			bool promotion = piece % 6 == P && (to / 8 == 0 || to / 8 == 7);
+
+			for (int option = 0; option < (promotion ? 4 : 1); option++) {
+				TablebasePosition& next = successors[count];
+				next.count = 0;
+				next.side = side ^ 1;
+				for (int j = 0; j < position.count; j++) {
+					if (capture && position.square[j] == to)
+						continue;
+					next.piece[next.count] = (j == i && promotion) ? side * 6 + promotions[option] : position.piece[j];
+					next.square[next.count++] = (j == i) ? to : position.square[j];
+				}
+				if (kingAttacked(moves, next, side))
+					continue;
+				converting[count++] = capture || promotion;
+			}
+		}
+	}
+	return count;
+}
+
+// legal positions one move of the side not to move earlier, without captures & promotions (other materials)
+static int generatePredecessors(const Moves& moves, const TablebasePosition& position, TablebasePosition* predecessors)
+{
+	int mover = position.side ^ 1;
+	uint64_t occupancy = occupancyOf(position, both);
+	int count = 0;
+
+	for (int i = 0; i < position.count; i++) {
+		int piece = position.piece[i];
+		if (piece / 6 != mover)
+			continue;
+		int to = position.square[i];
+
+		uint64_t sources = 0;
+		if (piece % 6 == P) {
+			int back = (mover == white) ? 8 : -8;
+			int row = (to + back) / 8;
+			if (row >= 1 && row <= 6 && !(occupancy & (1ULL << (to + back)))) {
+				sources |= 1ULL << (to + back);
+				if (to / 8 == ((mover == white) ? 4 : 3) && !(occupancy & (1ULL << (to + 2 * back))))
+					sources |= 1ULL << (to + 2 * back);
+			}
+		}
+		else
+			sources = pieceAttacks(moves, piece, to, occupancy) & ~occupancy;
+
+		while (sources) {
+			TablebasePosition& previous = predecessors[count];
+			previous = position;
+			previous.side = mover;
+			previous.square[i] = get_ls1b_index(sources);
+			sources &= sources - 1;
+			if (!kingAttacked(moves, previous, position.side))
+				count++;
+		}
+	}
+	return count;
+}
+
+// plies to mate of a value (wins odd, losses even) & back
+static inline int valueToPlies(int value) { return (value < 128) ? 2 * value - 1 : 2 * (value - 128); }
+static inline int winValue(int plies) { return (plies + 1) / 2; }
+static inline int lossValue(int plies) { return 128 + plies / 2; }
+
+// longest mate a value holds: wins up to 127 moves (253 plies), losses up to 127 moves (254 plies)
+const int max_tablebase_plies = 253;
+
+static uint32_t positionSignature(const TablebasePosition& position)
+{
+	uint32_t signature = 0;
+	for (int i = 0; i < position.count; i++)
+		if (position.piece[i] % 6 != K)
+			signature += 1 << (3 * signatureSlot(position.piece[i]));
+	return signature;
+}
+
+// position of the pieces on board
+static void boardPosition(const Board& board, TablebasePosition& position)
+{
+	position.count = 0;
+	position.side = board.side();
+	for (int piece = P; piece <= k; piece++) {
+		uint64_t bitboard = board.bitboards()[piece];
+		while (bitboard && position.count < max_tablebase_men) {
+			position.piece[position.count] = piece;
+			position.square[position.count++] = get_ls1b_index(bitboard);
+			bitboard &= bitboard - 1;
+		}
+	}
+}
+
+// run fn(begin, end) on chunks of [0, count) from every thread
+template <typename F>
+static void parallelFor(uint64_t count, int threads, F fn)
+{
+	const uint64_t chunk = 4096;
+	std::atomic<uint64_t> next{ 0 };
+	std::vector<std::thread> workers;
+	for (int thread = 0; thread < threads; thread++)
+		workers.emplace_back([&, thread]() {
+			for (uint64_t begin = next.fetch_add(chunk); begin < count; begin = next.fetch_add(chunk))
+				fn(begin, std::min(begin + chunk, count), thread);
+		});
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+//##################################################################################################################
+//                                                     TABLEBASES METHODS
+//##################################################################################################################
+
+int Tablebases::Table::value(uint64_t index) const {
+	uint64_t position = index % tablebase_block;
+	const uint8_t* control = blocks + offsets[index / tablebase_block];
+	while (true) {
+		// repeated value or literals
+		uint64_t length = (*control < 128) ? *control + 1 : *control - 127;
+		if (position < length)
+			return (*control < 128) ? control[1] : control[1 + position];
+		position -= length;
+		control += (*control < 128) ? 2 : 1 + length;
+	}
+}
+
+bool Tablebases::loadFile(const std::string& path) {
+	std::unique_ptr<Table> table(new Table());
+	if (!table->file.open(path) || table->file.size() < sizeof(TablebaseHeader))
+		return false;
+
+	TablebaseHeader header;
+	std::memcpy(&header, table->file.data(), sizeof(header));
+	if (std::memcmp(header.magic, "CNTB", 4) || header.version != tablebase_version)
+		return false;
+
+	for (int piece = P; piece <= k; piece++)
+		table->material.count[piece] = (piece % 6 == K) ? 1 : (header.signature >> (3 * signatureSlot(piece))) & 7;
+	setupMaterial(table->material);
+	if (table->material.signature != header.signature || table->material.size != header.size
+		|| header.blocks != (2 * header.size + tablebase_block - 1) / tablebase_block)
+		return false;
+
+	// the offsets have to be in the file before the last one gives the size of the blocks
+	uint64_t offsets_end = sizeof(header) + ((uint64_t)header.blocks + 1) * sizeof(uint64_t);
+	if (offsets_end > table->file.size())
+		return false;
+	table->offsets = (const uint64_t*)(table->file.data() + sizeof(header));
+	table->blocks = (const uint8_t*)(table->offsets + header.blocks + 1);
+	if (table->offsets[header.blocks] != table->file.size() - offsets_end)
+		return false;
+	for (uint32_t block = 0; block < header.blocks; block++)
+		if (table->offsets[block] > table->offsets[block + 1])
+			return false;
+
+	m_max_men = std::max(m_max_men, table->material.men);
+	m_tables[header.signature] = std::move(table);
+	return true;
+}
+
+int Tablebases::load(const std::string& directory) {
+	std::error_code error;
+	int loaded = 0;
+	for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+		if (entry.path().extension() == ".ctb")
+			loaded += loadFile(entry.path().string());
+	return loaded;
+}
+
+bool Tablebases::has(const TablebaseMaterial& material) const {
+	return m_tables.count(material.signature) || m_tables.count(flipSignature(material.signature));
+}
+
+bool Tablebases::probe(TablebasePosition position, int& value) const {
+	if (position.count == 2) {
+		value = 0;
+		return true;
+	}
+	if (position.count > m_max_men)
+		return false;
+
+	uint32_t signature = positionSignature(position);
+	auto found = m_tables.find(signature);
+	if (found == m_tables.end()) {
+		found = m_tables.find(flipSignature(signature));
+		if (found == m_tables.end())
+			return false;
+
+		// the other colour plays white in the table
+		for (int i = 0; i < position.count; i++) {
+			position.piece[i] = (position.piece[i] + 6) % 12;
+			position.square[i] ^= 56;
+		}
+		position.side ^= 1;
+	}
+
+	const Table& table = *found->second;
+	uint64_t index = positionIndex(table.material, position);
+	if (index == no_index)
+		return false;
+	value = table.value(position.side * table.material.size + index);
+	return true;
+}
+
+bool Tablebases::probe(const Board& board, int& value) const {
+	if (board.castle() || count_bits(board.occupancies()[both]) > m_max_men)
+		return false;
+
+	// an en passant capture the tables don't know
+	int side = board.side();
+	if (board.enpassant() != -1 && (sharedMoves().getPawnAttacks(side ^ 1, board.enpassant()) & board.bitboards()[side * 6 + P]))
+		return false;
+
+	TablebasePosition position;
+	boardPosition(board, position);
+	return probe(position, value);
+}
+
+//##################################################################################################################
+//                                                     GENERATOR
+//##################################################################################################################
+
+/*
+	Every position gets the number of its distinct successors within the material & the results of its
+	captures & promotions from the tables they convert to. Positions are then resolved in order of
+	their distance to mate: a position lost in n plies makes its predecessors won in n + 1, a position
+	won in n removes one successor from its predecessors, the ones left without a successor that
+	doesn't lose (and without a drawing conversion) are lost in n + 1 (or after their longest
+	conversion). Both the first pass & every layer run on all threads, the positions never resolved
+	are draws.
+*/
+
+// scheduled result: position << 1 | win
+typedef std::vector<std::vector<uint64_t>> tablebaseLayers;
+
+static void schedule(std::vector<std::pair<int, uint64_t>>& scheduled, uint64_t position, bool win, int plies) {
+	scheduled.push_back({ plies, (position << 1) | (win ? 1 : 0) });
+}
+
+static void mergeScheduled(tablebaseLayers& layers, std::vector<std::vector<std::pair<int, uint64_t>>>& scheduled) {
+	for (auto& thread_scheduled : scheduled) {
+		for (const auto& entry : thread_scheduled) {
+			if (entry.first >= (int)layers.size())
+				layers.resize(entry.first + 1);
+			layers[entry.first].push_back(entry.second);
+		}
+		thread_scheduled.clear();
+	}
+}
+
+enum { position_unknown, position_resolved, position_invalid };
+
+// values of both sides to move & the state of each index (invalid: no position, any value will do), false when
+// tables of the conversions are missing or a mate is too long for the values
+static bool solveTablebase(const TablebaseMaterial& material, int threads, const Tablebases& tablebases, std::vector<uint8_t>& values,
+	std::vector<uint8_t>& state)
+{
+	const Moves& moves = sharedMoves();
+	uint64_t size = material.size;
+	values.assign(2 * size, 0);
+	state.assign(2 * size, position_unknown);
+	std::vector<std::atomic<uint8_t>> remaining(2 * size);
+	std::vector<uint8_t> loss_floor(2 * size, 0);
+	std::vector<std::vector<std::pair<int, uint64_t>>> scheduled(threads);
+	std::atomic<bool> missing{ false };
+	tablebaseLayers layers;
+
+	parallelFor(2 * size, threads, [&](uint64_t begin, uint64_t end, int thread) {
+		TablebasePosition position, successors[max_moves];
+		bool converting[max_moves];
+		uint64_t indexes[max_moves];
+
+		for (uint64_t id = begin; id < end; id++) {
+			int side = (int)(id / size);
+			uint64_t index = id % size;
+			if (!decodeIndex(material, index, side, position) || kingAttacked(moves, position, side ^ 1)
+				|| positionIndex(material, position) != index) {
+				state[id] = position_invalid;
+				continue;
+			}
+
+			int count = generateSuccessors(moves, position, successors, converting);
+			if (!count) {
+				// mated or stalemate
+				if (kingAttacked(moves, position, side))
+					schedule(scheduled[thread], id, false, 0);
+				else
+					state[id] = position_resolved;
+				continue;
+			}
+
+			int best_win = 255, longest_loss = 0, distinct = 0;
+			bool draw = false;
+			for (int i = 0; i < count; i++) {
+				if (!converting[i]) {
+					indexes[distinct++] = (side ^ 1) * size + positionIndex(material, successors[i]);
+					continue;
+				}
+				int value;
+				if (!tablebases.probe(successors[i], value)) {
+					missing = true;
+					value = 0;
+				}
+				if (!value)
+					draw = true;
+				else if (value >= 128)
+					best_win = std::min(best_win, valueToPlies(value) + 1);
+				else
+					longest_loss = std::max(longest_loss, valueToPlies(value));
+			}
+			std::sort(indexes, indexes + distinct);
+			distinct = (int)(std::unique(indexes, indexes + distinct) - indexes);
+
+			remaining[id].store((uint8_t)distinct, std::memory_order_relaxed);
+			loss_floor[id] = (draw || best_win < 255) ? 255 : (uint8_t)longest_loss;
+			if (best_win < 255)
+				schedule(scheduled[thread], id, true, best_win);
+			else if (!distinct && !draw)
+				schedule(scheduled[thread], id, false, longest_loss + 1);
+		}
+	});
+	if (missing) {
+		printf("  %s: missing tables\n", material.name().c_str());
+		return false;
+	}
+	mergeScheduled(layers, scheduled);
+
+	std::vector<uint64_t> frontier;
+	for (int plies = 0; plies < (int)layers.size(); plies++) {
+		// the first result reaching a position is the fastest
+		frontier.clear();
+		for (uint64_t entry : layers[plies]) {
+			uint64_t id = entry >> 1;
+			if (state[id] != position_unknown)
+				continue;
+			if (plies > max_tablebase_plies) {
+				printf("  %s: mate in more than %d plies doesn't fit the values\n", material.name().c_str(), max_tablebase_plies);
+				return false;
+			}
+			state[id] = position_resolved;
+			values[id] = (uint8_t)((entry & 1) ? winValue(plies) : lossValue(plies));
+			frontier.push_back(entry);
+		}
+		std::vector<uint64_t>().swap(layers[plies]);
+
+		parallelFor(frontier.size(), threads, [&](uint64_t begin, uint64_t end, int thread) {
+			TablebasePosition position, predecessors[max_moves];
+			uint64_t indexes[max_moves];
+
+			for (uint64_t i = begin; i < end; i++) {
+				uint64_t id = frontier[i] >> 1;
+				bool win = frontier[i] & 1;
+				int side = (int)(id / size);
+				decodeIndex(material, id % size, side, position);
+
+				int count = generatePredecessors(moves, position, predecessors);
+				for (int j = 0; j < count; j++)
+					indexes[j] = (side ^ 1) * size + positionIndex(material, predecessors[j]);
+				std::sort(indexes, indexes + count);
+				count = (int)(std::unique(indexes, indexes + count) - indexes);
+
+				for (int j = 0; j < count; j++) {
+					uint64_t previous = indexes[j];
+					if (state[previous] != position_unknown)
+						continue;
+					if (!win)
+						schedule(scheduled[thread], previous, true, plies + 1);
+					else if (remaining[previous].fetch_sub(1, std::memory_order_relaxed) == 1 && loss_floor[previous] != 255)
+						schedule(scheduled[thread], previous, false, std::max(plies, (int)loss_floor[previous]) + 1);
+				}
+			}
+		});
+		mergeScheduled(layers, scheduled);
+	}
+	return true;
+}
+
+// blocks compressed behind their offsets: a control byte below 128 repeats the next byte control + 1 times,
+// from 128 on control - 127 literal bytes follow. Invalid indexes repeat the value before them.
+static bool writeTablebase(const std::string& path, const TablebaseMaterial& material, std::vector<uint8_t>& values,
+	const std::vector<uint8_t>& state, uint64_t& bytes)
+{
+	for (uint64_t i = 1; i < values.size(); i++)
+		if (state[i] == position_invalid)
+			values[i] = values[i - 1];
+
+	TablebaseHeader header;
+	std::memcpy(header.magic, "CNTB", 4);
+	header.version = tablebase_version;
+	header.signature = material.signature;
+	header.size = material.size;
+	header.blocks = (uint32_t)((values.size() + tablebase_block - 1) / tablebase_block);
+
+	std::vector<uint64_t> offsets(header.blocks + 1, 0);
+	std::vector<uint8_t> blocks;
+	for (uint32_t block = 0; block < header.blocks; block++) {
+		offsets[block] = blocks.size();
+		uint64_t end = std::min<uint64_t>((uint64_t)(block + 1) * tablebase_block, values.size());
+		uint64_t literals = 0;
+		for (uint64_t i = (uint64_t)block * tablebase_block; i < end;) {
+			uint64_t run = 1;
+			while (i + run < end && run < 128 && values[i + run] == values[i])
+				run++;
+
+			// short runs join the literals before them
+			if (run < 3) {
+				if (!literals || blocks[literals] == 255) {
+					literals = blocks.size();
+					blocks.push_back(127);
+				}
+				blocks[literals]++;
+				blocks.push_back(values[i++]);
+				continue;
+			}
+			literals = 0;
+			blocks.push_back((uint8_t)(run - 1));
+			blocks.push_back(values[i]);
+			i += run;
+		}
+	}
+	offsets[header.blocks] = blocks.size();
+
+	std::ofstream out(path, std::ios::binary);
+	if (!out)
+		return false;
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)offsets.data(), offsets.size() * sizeof(uint64_t));
+	out.write((const char*)blocks.data(), blocks.size());
+	bytes = sizeof(header) + offsets.size() * sizeof(uint64_t) + blocks.size();
+	return (bool)out;
+}
+
+bool generateTablebase(const std::string& name, const std::string& directory, int threads, Tablebases& tablebases)
+{
+	TablebaseMaterial material;
+	if (!material.parse(name)) {
+		printf("  %s: not a material of %d men or less\n", name.c_str(), max_tablebase_men);
+		return false;
+	}
+	if (material.men == 2 || tablebases.has(material))
+		return true;
+
+	// every capture & promotion first
+	for (int piece = P; piece <= k; piece++) {
+		if (piece % 6 == K || !material.count[piece])
+			continue;
+		TablebaseMaterial capture = material;
+		capture.count[piece]--;
+		setupMaterial(capture);
+		if (!generateTablebase(capture.name(), directory, threads, tablebases))
+			return false;
+
+		for (int promoted = N; piece % 6 == P && promoted <= Q; promoted++) {
+			TablebaseMaterial promotion = material;
+			promotion.count[piece]--;
+			promotion.count[(piece / 6) * 6 + promoted]++;
+			setupMaterial(promotion);
+			if (!generateTablebase(promotion.name(), directory, threads, tablebases))
+				return false;
+		}
+	}
+
+	uint64_t start = get_time_ms();
+	std::vector<uint8_t> values, state;
+	if (!solveTablebase(material, threads, tablebases, values, state))
+		return false;
+
+	std::string path = (std::filesystem::path(directory) / (material.name() + ".ctb")).string();
+	uint64_t bytes = 0;
+	uint64_t positions = 0, wins = 0, losses = 0;
+	int longest = 0;
+	for (uint64_t i = 0; i < values.size(); i++) {
+		if (state[i] == position_invalid)
+			continue;
+		positions++;
+		wins += values[i] && values[i] < 128;
+		losses += values[i] >= 128;
+		if (values[i] < 128)
+			longest = std::max(longest, (int)values[i]);
+	}
+	if (!writeTablebase(path, material, values, state, bytes) || !tablebases.loadFile(path)) {
+		printf("  %s: can't write %s\n", material.name().c_str(), path.c_str());
+		return false;
+	}
+	printf("  %-8s %10llu positions %9llu wins %9llu losses  longest mate %3d  %7.2f MB -> %6.2f MB  %6llu ms\n",
+		material.name().c_str(), (unsigned long long)positions, (unsigned long long)wins, (unsigned long long)losses, longest,
+		values.size() / 1048576.0, bytes / 1048576.0, (unsigned long long)(get_time_ms() - start));
+	return true;
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+static std::string positionFen(const TablebasePosition& position)
+{
+	const char letters[] = "PNBRQKpnbrqk";
+	char board[64];
+	std::memset(board, 0, sizeof(board));
+	for (int i = 0; i < position.count; i++)
+		board[position.square[i]] = letters[position.piece[i]];
+
+	std::string fen;
+	for (int row = 0; row < 8; row++) {
+		int empty = 0;
+		for (int file = 0; file < 8; file++) {
+			if (!board[row * 8 + file]) {
+				empty++;
+				continue;
+			}
+			if (empty)
+				fen += (char)('0' + empty);
+			empty = 0;
+			fen += board[row * 8 + file];
+		}
+		if (empty)
+			fen += (char)('0' + empty);
+		if (row < 7)
+			fen += '/';
+	}
+	return fen + ((position.side == white) ? " w - - 0 1" : " b - - 0 1");
+}
+
+void tablebaseTest(const std::string& directory, int threads)
+{
+	const char* names[] = { "KQvK", "KRvK", "KPvK", "KQvKR", "KRvKB", "KPvKP" };
+	const Moves& moves = sharedMoves();
+
+	Tablebases tablebases;
+	std::filesystem::create_directories(directory);
+	printf("\n     Tablebases (%d threads, %d tables in %s)\n\n", threads, tablebases.load(directory), directory.c_str());
+	for (const char* name : names)
+		if (!generateTablebase(name, directory, threads, tablebases))
+			return;
+
+	// win or draw of every kpk position against the bitbase
+	int kpk_mismatches = 0;
+	TablebasePosition position;
+	position.count = 3;
+	for (int side = white; side <= black; side++)
+		for (int white_king = 0; white_king < 64; white_king++)
+			for (int black_king = 0; black_king < 64; black_king++)
+				for (int pawn = 8; pawn < 56; pawn++) {
+					position.side = side;
+					position.piece[0] = K, position.square[0] = white_king;
+					position.piece[1] = k, position.square[1] = black_king;
+					position.piece[2] = P, position.square[2] = pawn;
+					if (white_king == black_king || white_king == pawn || black_king == pawn
+						|| (moves.getKingAttacks(white_king) & (1ULL << black_king)) || kingAttacked(moves, position, side ^ 1))
+						continue;
+					// values are from the side to move
+					int value = 0;
+					tablebases.probe(position, value);
+					bool win = (side == white) ? (value && value < 128) : value >= 128;
+					kpk_mismatches += win != probeKpk(white, white_king, pawn, black_king, side);
+				}
+
+	// value of sampled positions against the best of their legal moves from the move generator
+	Board b;
+	std::vector<uint64_t> move_list;
+	uint64_t state = 1;
+	printf("\n  kpk bitbase mismatches %d\n\n", kpk_mismatches);
+	for (const char* name : names) {
+		TablebaseMaterial material;
+		material.parse(name);
+		int checked = 0, mismatches = 0;
+
+		for (int sample = 0; sample < 20000; sample++) {
+			state ^= state >> 12, state ^= state << 25, state ^= state >> 27;
+			uint64_t index = (state * 2685821657736338717ULL) % material.size;
+			int side = sample & 1;
+			if (!decodeIndex(material, index, side, position) || kingAttacked(moves, position, side ^ 1))
+				continue;
+
+			int value, expected = -1, best_win = 255, longest_loss = -1;
+			bool draw = false;
+			tablebases.probe(position, value);
+			b.parse_fen(positionFen(position));
+			move_list.clear();
+			b.generateMoves(&move_list);
+			for (uint64_t move : move_list) {
+				b.copyBoard();
+				if (!b.makeMove((int)move, all_moves)) {
+					b.clearCopy();
+					continue;
+				}
+				TablebasePosition next;
+				int next_value;
+				boardPosition(b, next);
+				tablebases.probe(next, next_value);
+				if (!next_value)
+					draw = true;
+				else if (next_value >= 128)
+					best_win = std::min(best_win, valueToPlies(next_value) + 1);
+				else
+					longest_loss = std::max(longest_loss, valueToPlies(next_value) + 1);
+				b.takeBack();
+			}
+
+			if (best_win < 255)
+				expected = winValue(best_win);
+			else if (draw)
+				expected = 0;
+			else if (longest_loss >= 0)
+				expected = lossValue(longest_loss);
+			else
+				expected = b.inCheck() ? lossValue(0) : 0;
+			checked++;
+			mismatches += value != expected;
+		}
+		printf("  %-8s %6d positions against the move generator, mismatches %d\n", name, checked, mismatches);
+	}
+
+	// probe throughput through the mapped files
+	b.parse_fen("8/8/8/4k3/8/8/2K5/6Rq w - - 0 1");
+	const int probes = 1000000;
+	int value = 0, sum = 0;
+	uint64_t start = get_time_ns();
+	for (int i = 0; i < probes; i++) {
+		tablebases.probe(b, value);
+		sum += value;
+	}
+	printf("\n  probe %.1f ns (value %d)\n\n", (double)(get_time_ns() - start) / probes, sum / probes);
+}
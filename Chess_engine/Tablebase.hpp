@@ -0,0 +1,110 @@
+#pragma once
+#include "Board.hpp"
+#include "Utility.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/*
+		  endgame tablebases
+
+	One file per material (KQvK.ctb, KRPvKR.ctb, ...), the side named first is the stronger one and plays
+	white in the table, positions with the colours swapped are probed with the board flipped.
+
+	index of a position (for each side to move):
+
+		king pair     without pawns the white king in the a1-d1-d4 triangle (the black king on or below the
+		              a1-h8 diagonal while the white king is on it), with pawns the white king on files a-d
+		x pieces      for each kind of piece (white queens, ..., black pawns) the combination of its squares,
+		              C(64, n) for n identical pieces & C(48, n) for pawns (ranks 2-7)
+
+	a position with several indexes (both kings on the diagonal) takes the smallest one. One byte per position:
+	0 draw, 1-127 the side to move mates in that many moves, 128-255 the side to move is mated in value - 128
+	moves (indexes without a position repeat the value before them). The file holds the white to move values then the black to move ones in blocks of
+	tablebase_block positions, each run length compressed (runs & literals), behind the table of the block
+	offsets: a probe decodes a single block.
+
+	en passant & castling rights aren't part of the positions, probes skip boards with them.
+*/
+
+// kings included
+const int max_tablebase_men = 5;
+
+// positions of a compressed block
+const int tablebase_block = 1024;
+
+// pieces & side to move of a position
+struct TablebasePosition {
+	int count = 0;
+	int piece[max_tablebase_men];
+	int square[max_tablebase_men];
+	int side = white;
+};
+
+// pieces of a material & the layout of its index
+struct TablebaseMaterial {
+	// piece counts [piece], kings included
+	int count[12] = {};
+	int men = 0;
+	bool pawns = false;
+
+	// kinds of pieces in index order, their number & index range
+	int groups = 0;
+	int group_piece[max_tablebase_men];
+	int group_count[max_tablebase_men];
+	uint64_t group_size[max_tablebase_men];
+
+	// positions for each side to move
+	uint64_t size = 0;
+
+	// piece counts packed, white pieces in the low half
+	uint32_t signature = 0;
+
+	// KRPvKR notation, kings included
+	bool parse(const std::string& name);
+	std::string name() const;
+};
+
+class Tablebases {
+
+	struct Table {
+		TablebaseMaterial material;
+		MappedFile file;
+		const uint64_t* offsets = nullptr;
+		const uint8_t* blocks = nullptr;
+
+		// value at index in the compressed blocks
+		int value(uint64_t index) const;
+	};
+
+	// tables by material signature
+	std::unordered_map<uint32_t, std::unique_ptr<Table>> m_tables;
+
+	int m_max_men = 0;
+
+public:
+
+	// map every table file of directory, returns the number of tables
+	int load(const std::string& directory);
+
+	// map one table file
+	bool loadFile(const std::string& path);
+
+	int tables() const { return (int)m_tables.size(); }
+
+	// men of the largest table
+	int maxMen() const { return m_max_men; }
+
+	// a table for the material (either colour)
+	bool has(const TablebaseMaterial& material) const;
+
+	// value (see above) of the position, false without its table; positions with kings only are draws
+	bool probe(TablebasePosition position, int& value) const;
+	bool probe(const Board& board, int& value) const;
+};
+
+// generate the table of material, first the ones its captures & promotions convert to, into directory (threads in parallel)
+bool generateTablebase(const std::string& name, const std::string& directory, int threads, Tablebases& tablebases);
+
+// generate & verify tables (against the kpk bitbase & the move generator) in directory
+void tablebaseTest(const std::string& directory, int threads);
@@ -0,0 +1,181 @@
+#include "TimeManager.hpp"
+#include "Board.hpp"
+#include "Search.hpp"
+#include "Utility.hpp"
+#include <cassert>
+#include <cstdio>
+
+//##################################################################################################################
+//                                                     TIME MANAGER METHODS
+//##################################################################################################################
+
+void TimeManager::setThreads(int threads) {
+	if (threads < 1)
+		threads = 1;
+	if (threads != m_slot_count) {
+		m_slots.reset(new nodeSlot[threads]);
+		m_slot_count = threads;
+	}
+	for (int thread = 0; thread < m_slot_count; ++thread)
+		m_slots[thread].nodes.store(0, std::memory_order_relaxed);
+	setNodeShare();
+}
+
+void TimeManager::setNodeShare() {
+	m_thread_node_limit = m_node_limit ? (m_node_limit + m_slot_count - 1) / m_slot_count : 0;
+}
+
+void TimeManager::start(const SearchLimits& limits, int side) {
+	m_start_ns = get_time_ns();
+	m_stop.store(false, std::memory_order_relaxed);
+	for (int thread = 0; thread < m_slot_count; ++thread)
+		m_slots[thread].nodes.store(0, std::memory_order_relaxed);
+
+	m_soft_ns = 0;
+	m_hard_ns = 0;
+	m_node_limit = limits.nodes;
+	m_depth_limit = limits.depth;
+	setNodeShare();
+
+	// the clock starts at ponderhit
+	m_ponder_limits = limits;
+	m_ponder_side = side;
+	m_pondering.store(limits.ponder, std::memory_order_release);
+	if (limits.ponder)
+		return;
+
+	setBudgets(limits, side);
+}
+
+void TimeManager::ponderhit() {
+	if (!pondering())
+		return;
+	m_start_ns = get_time_ns();
+	setBudgets(m_ponder_limits, m_ponder_side);
+	m_pondering.store(false, std::memory_order_release);
+}
+
+void TimeManager::setBudgets(const SearchLimits& limits, int side) {
+	if (limits.infinite)
+		return;
+
+	uint64_t soft_ms = 0, hard_ms = 0;
+
+	// fixed time per move, all of it
+	if (limits.movetime) {
+		soft_ms = hard_ms = (limits.movetime > move_overhead) ? limits.movetime - move_overhead : 1;
+	}
+
+	// clock: a share of the remaining time plus most of the increment, at most a few times that when needed
+	else if (limits.time[side]) {
+		uint64_t time_left = (limits.time[side] > move_overhead) ? limits.time[side] - move_overhead : 1;
+		uint64_t moves_to_go = limits.movestogo ? limits.movestogo : 30;
+
+		soft_ms = time_left / moves_to_go + limits.inc[side] * 3 / 4;
+		hard_ms = soft_ms * 4;
+
+		// never more than the clock allows
+		if (hard_ms > time_left / 2 + limits.inc[side])
+			hard_ms = time_left / 2 + limits.inc[side];
+		if (hard_ms > time_left)
+			hard_ms = time_left;
+		if (soft_ms > hard_ms)
+			soft_ms = hard_ms;
+		if (!soft_ms)
+			soft_ms = hard_ms = 1;
+	}
+
+	m_soft_ns = soft_ms * 1000000;
+	m_hard_ns = hard_ms * 1000000;
+}
+
+bool TimeManager::poll(int thread, uint64_t nodes) {
+	// own cache line, no other thread writes it (setThreads gives every worker thread a slot)
+	assert(thread >= 0 && thread < m_slot_count);
+	m_slots[thread].nodes.store(nodes, std::memory_order_relaxed);
+
+	if (stopped())
+		return true;
+
+	// the node limit is checked against the thread's own share, the other slots aren't read
+	if ((m_hard_ns && get_time_ns() - m_start_ns >= m_hard_ns) || (m_thread_node_limit && nodes >= m_thread_node_limit)) {
+		stop();
+		return true;
+	}
+	return false;
+}
+
+bool TimeManager::softExpired() const {
+	if (stopped())
+		return true;
+	if (m_node_limit && nodes() >= m_node_limit)
+		return true;
+	return m_soft_ns && get_time_ns() - m_start_ns >= m_soft_ns;
+}
+
+uint64_t TimeManager::nodes() const {
+	uint64_t total = 0;
+	for (int thread = 0; thread < m_slot_count; ++thread)
+		total += m_slots[thread].nodes.load(std::memory_order_relaxed);
+	return total;
+}
+
+uint64_t TimeManager::elapsedMs() const {
+	return (get_time_ns() - m_start_ns) / 1000000;
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+void timeManagerTest() {
+	TimeManager time;
+
+	// budgets of a few clock situations
+	printf("\n    %10s %10s %10s %10s %10s\n\n", "time", "inc", "movestogo", "soft ms", "hard ms");
+	const uint64_t clocks[][3] = { { 60000, 0, 0 }, { 60000, 1000, 0 }, { 5000, 0, 0 }, { 300000, 0, 40 }, { 100, 50, 0 }, { 20, 0, 0 } };
+	for (const auto& clock : clocks) {
+		SearchLimits limits;
+		limits.time[white] = clock[0];
+		limits.inc[white] = clock[1];
+		limits.movestogo = (int)clock[2];
+		time.start(limits, white);
+		printf("    %10llu %10llu %10llu %10llu %10llu\n", (unsigned long long)clock[0], (unsigned long long)clock[1],
+			(unsigned long long)clock[2], (unsigned long long)time.softMs(), (unsigned long long)time.hardMs());
+	}
+
+	// perft interrupted by movetime, single & multi threaded
+	SearchLimits limits;
+	limits.movetime = 200;
+	time.start(limits, white);
+	perftTest("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 ", 6, &time);
+
+	time.start(limits, white);
+	uint64_t nodes = perftParallel("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 ", 6, 4, &time);
+	printf("    Parallel perft stopped after %llu ms, %llu nodes\n", (unsigned long long)time.elapsedMs(), (unsigned long long)nodes);
+
+	// search limited by nodes
+	Board b;
+	b.parse_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 ");
+	TranspositionTable tt(16);
+	Search search;
+	search.setTranspositionTable(&tt);
+	// one searching thread: the whole node limit is its share
+	time.setThreads(1);
+	search.setTimeManager(&time);
+	search.setPosition(b);
+
+	limits = SearchLimits();
+	limits.nodes = 100000;
+	time.start(limits, white);
+	SearchResult result = search.searchPosition(max_ply - 1, false);
+	printf("    Node limit %llu: searched %llu nodes, depth %d\n", (unsigned long long)limits.nodes,
+		(unsigned long long)result.nodes, result.depth);
+
+	limits = SearchLimits();
+	limits.movetime = 300;
+	time.start(limits, white);
+	result = search.searchPosition(max_ply - 1, false);
+	printf("    Movetime %llu ms: stopped after %llu ms, depth %d\n", (unsigned long long)limits.movetime,
+		(unsigned long long)time.elapsedMs(), result.depth);
+}
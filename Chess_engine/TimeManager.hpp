@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// limits of a search (UCI go parameters), 0 when not given
+struct SearchLimits {
+	// fixed time per move in milliseconds
+	uint64_t movetime = 0;
+
+	// clock & increment in milliseconds [side]
+	uint64_t time[2] = {};
+	uint64_t inc[2] = {};
+	int movestogo = 0;
+
+	uint64_t nodes = 0;
+	int depth = 0;
+
+	// search until stopped
+	bool infinite = false;
+
+	// search until ponderhit (the limits apply from then on) or stopped
+	bool ponder = false;
+};
+
+// nodes between two polls of the limits by a worker thread
+const int poll_interval = 1024;
+
+// time kept back for the communication with the GUI, in milliseconds
+const uint64_t move_overhead = 10;
+
+/*
+		Time manager
+
+	start() turns the limits into a soft budget (don't start another iteration)
+	and a hard budget (stop now). Worker threads call poll() every poll_interval
+	nodes: it publishes their node count in a slot of their own (one cache line
+	per thread, so no line is written by two threads) and checks the hard limits,
+	the node limit against its own share of it (limit / threads). A poll never
+	reads the slots of the other threads, the stop flag is read by every thread
+	but only written once.
+*/
+
+class TimeManager {
+
+	// node count published by each thread
+	struct alignas(64) nodeSlot {
+		std::atomic<uint64_t> nodes{ 0 };
+	};
+	std::unique_ptr<nodeSlot[]> m_slots;
+	int m_slot_count = 0;
+
+	std::atomic<bool> m_stop{ false };
+
+	// written by ponderhit() while the workers poll: the start first, then the budgets
+	std::atomic<uint64_t> m_start_ns{ 0 };
+
+	// budgets in nanoseconds from the start, 0 for none
+	std::atomic<uint64_t> m_soft_ns{ 0 };
+	std::atomic<uint64_t> m_hard_ns{ 0 };
+
+	// limits & side of a ponder search, applied at ponderhit
+	std::atomic<bool> m_pondering{ false };
+	SearchLimits m_ponder_limits;
+	int m_ponder_side = 0;
+
+	// soft & hard budgets of the limits for side
+	void setBudgets(const SearchLimits& limits, int side);
+
+	uint64_t m_node_limit = 0;
+	int m_depth_limit = 0;
+
+	// node limit of each thread, polled without reading the slots of the others
+	uint64_t m_thread_node_limit = 0;
+	void setNodeShare();
+
+public:
+
+	explicit TimeManager(int threads = 1) { setThreads(threads); }
+
+	TimeManager(const TimeManager&) = delete;
+	TimeManager& operator=(const TimeManager&) = delete;
+
+	// one node slot per worker thread (clears the slots), the node limit is split between them
+	void setThreads(int threads);
+
+	// start the clock & compute the budgets of the side to move (none until ponderhit when pondering)
+	void start(const SearchLimits& limits, int side);
+
+	// the ponder move was played: restart the clock under the limits of the search, callable from any thread
+	void ponderhit();
+
+	bool pondering() const { return m_pondering.load(std::memory_order_acquire); }
+
+	// publish the nodes of thread (below the thread count of setThreads), true when the search has to stop
+	bool poll(int thread, uint64_t nodes);
+
+	// the soft budget is used up, don't start a new iteration
+	bool softExpired() const;
+
+	bool stopped() const { return m_stop.load(std::memory_order_relaxed); }
+
+	// stop every thread at its next poll, callable from any thread
+	void stop() { m_stop.store(true, std::memory_order_relaxed); }
+
+	// published nodes of all threads
+	uint64_t nodes() const;
+
+	uint64_t elapsedMs() const;
+
+	uint64_t softMs() const { return m_soft_ns / 1000000; }
+	uint64_t hardMs() const { return m_hard_ns / 1000000; }
+	uint64_t nodeLimit() const { return m_node_limit; }
+	int depthLimit() const { return m_depth_limit; }
+};
+
+void timeManagerTest();
@@ -0,0 +1,212 @@
+#include "TranspositionTable.hpp"
+#include "Search.hpp"
+#include <climits>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//##################################################################################################################
+//                                                     FUNCTIONS
+//##################################################################################################################
+
+// high 64 bits of a 64x64 bit product, maps a key to [0, range)
+static inline uint64_t mulHi64(uint64_t a, uint64_t b) {
+#if defined(_MSC_VER)
+	return __umulh(a, b);
+#else
+	return (uint64_t)(((unsigned __int128)a * b) >> 64);
+#endif
+}
+
+static inline uint64_t packData(int move, int score, int depth, int bound, int age) {
+	return (uint64_t)(uint16_t)move
+		| ((uint64_t)(uint16_t)(int16_t)score << 16)
+		| ((uint64_t)(uint8_t)depth << 32)
+		| ((uint64_t)(bound & 3) << 40)
+		| ((uint64_t)(age & 63) << 42);
+}
+
+// key check of an entry (bits 48-63)
+static inline uint64_t keyCheck(uint64_t key) {
+	return key << 48;
+}
+
+static const uint64_t key_check_mask = 0xffffULL << 48;
+
+static inline void unpackData(uint64_t data, TTData& tt_data) {
+	tt_data.move = (int)(data & 0xffff);
+	tt_data.score = (int16_t)((data >> 16) & 0xffff);
+	tt_data.depth = (int)((data >> 32) & 0xff);
+	tt_data.bound = (int)((data >> 40) & 3);
+	tt_data.age = (int)((data >> 42) & 63);
+}
+
+int compactMove(int move) {
+	// source & target squares (12 bits), promoted piece (4 bits)
+	return (move & 0xfff) | ((move >> 4) & 0xf000);
+}
+
+//##################################################################################################################
+//                                                     TRANSPOSITION TABLE METHODS
+//##################################################################################################################
+
+TranspositionTable::~TranspositionTable() {
+	delete[] m_clusters;
+}
+
+TTCluster* TranspositionTable::cluster(uint64_t key) const {
+	return &m_clusters[mulHi64(key, m_cluster_count)];
+}
+
+void TranspositionTable::resize(size_t mb) {
+	delete[] m_clusters;
+	m_cluster_count = (mb ? mb : 1) * 1024 * 1024 / sizeof(TTCluster);
+	m_clusters = new TTCluster[m_cluster_count];
+	clear();
+}
+
+void TranspositionTable::clear() {
+	for (size_t index = 0; index < m_cluster_count; ++index) {
+		for (TTEntry& entry : m_clusters[index].m_entries)
+			entry.m_entry.store(0, std::memory_order_relaxed);
+	}
+	m_age = 0;
+}
+
+void TranspositionTable::newSearch() {
+	m_age = (m_age + 1) & 63;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData& data) const {
+	TTCluster* tt_cluster = cluster(key);
+
+	for (TTEntry& entry : tt_cluster->m_entries) {
+		uint64_t entry_data = entry.m_entry.load(std::memory_order_relaxed);
+
+		if ((entry_data & key_check_mask) == keyCheck(key) && ((entry_data >> 40) & 3) != bound_none) {
+			unpackData(entry_data, data);
+			return true;
+		}
+	}
+	return false;
+}
+
+void TranspositionTable::store(uint64_t key, int move, int score, int depth, int bound) {
+	TTCluster* tt_cluster = cluster(key);
+
+	TTEntry* replace = &tt_cluster->m_entries[0];
+	int replace_value = INT_MAX;
+
+	for (TTEntry& entry : tt_cluster->m_entries) {
+		uint64_t entry_data = entry.m_entry.load(std::memory_order_relaxed);
+		bool same_key = (entry_data & key_check_mask) == keyCheck(key);
+
+		TTData old;
+		unpackData(entry_data, old);
+
+		// same position or empty slot
+		if (same_key || old.bound == bound_none) {
+			if (same_key && old.bound != bound_none) {
+				// keep the known move
+				if (!move)
+					move = old.move;
+
+				// don't trade a deeper result of this search for a shallow bound
+				if (bound != bound_exact && old.age == m_age && depth + 3 < old.depth)
+					return;
+			}
+			replace = &entry;
+			break;
+		}
+
+		// otherwise replace the shallowest entry, entries of older searches first
+		int relative_age = (m_age - old.age) & 63;
+		int value = old.depth - 8 * relative_age;
+		if (value < replace_value) {
+			replace_value = value;
+			replace = &entry;
+		}
+	}
+
+	replace->m_entry.store(keyCheck(key) | packData(move, score, depth, bound, m_age), std::memory_order_relaxed);
+}
+
+void TranspositionTable::prefetch(uint64_t key) const {
+#if defined(__GNUC__)
+	__builtin_prefetch(cluster(key));
+#else
+	_mm_prefetch((const char*)cluster(key), _MM_HINT_T0);
+#endif
+}
+
+int TranspositionTable::hashfull() const {
+	size_t samples = m_cluster_count < 1000 ? m_cluster_count : 1000;
+	int used = 0;
+
+	for (size_t index = 0; index < samples; ++index) {
+		for (TTEntry& entry : m_clusters[index].m_entries) {
+			TTData data;
+			unpackData(entry.m_entry.load(std::memory_order_relaxed), data);
+			if (data.bound != bound_none && data.age == m_age)
+				used++;
+		}
+	}
+	return samples ? (int)(used * 1000 / (samples * 4)) : 0;
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+void transpositionTableTest() {
+	TranspositionTable tt(1);
+
+	// store & probe round trip
+	TTData data;
+	tt.store(0x123456789abcdefULL, 0xabcd, -321, 7, bound_lower);
+	bool found = tt.probe(0x123456789abcdefULL, data);
+	std::cout << "Round trip : " << found << " move " << std::hex << data.move << std::dec << " score " << data.score
+		<< " depth " << data.depth << " bound " << data.bound << std::endl;
+
+	// mate scores at every ply & the bounds keep their value
+	int score_errors = 0;
+	for (int ply = 0; ply < max_ply; ++ply) {
+		for (int score : { mate_value - ply, -(mate_value - ply), infinity, -infinity }) {
+			uint64_t key = 0x9e3779b97f4a7c15ULL * (ply + 1);
+			tt.store(key, 0, score, 1, bound_exact);
+			if (!tt.probe(key, data) || data.score != score)
+				score_errors++;
+		}
+	}
+	std::cout << "Mate & bound scores : " << score_errors << " errors" << std::endl;
+
+	// several threads hammer a tiny table, the data of every hit must belong to its key
+	tt.resize(1);
+	std::atomic<uint64_t> hits(0), corrupted(0);
+	std::vector<std::thread> workers;
+	for (int thread = 0; thread < 4; ++thread) {
+		workers.emplace_back([&, thread]() {
+			uint64_t state = 0x9e3779b97f4a7c15ULL * (thread + 1);
+			for (int iteration = 0; iteration < 1000000; ++iteration) {
+				state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+				// 64k distinct keys spread over the whole table
+				uint64_t key = (state & 0xffffULL) * 0x9e3779b97f4a7c15ULL;
+				TTData entry;
+				if (tt.probe(key, entry)) {
+					hits++;
+					if (entry.move != (int)(key >> 48) || entry.depth != (int)(key % 64))
+						corrupted++;
+				}
+				tt.store(key, (int)(key >> 48), 0, (int)(key % 64), bound_exact);
+			}
+		});
+	}
+	for (auto& worker : workers)
+		worker.join();
+
+	std::cout << "Concurrent hits : " << hits << " corrupted : " << corrupted << std::endl;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+// score bound of an entry
+enum { bound_none, bound_upper, bound_lower, bound_exact };
+
+// unpacked entry data
+struct TTData {
+	// 16 bit move (source | target << 6 | promoted << 12)
+	int move = 0;
+	int score = 0;
+	int depth = 0;
+	int bound = bound_none;
+	int age = 0;
+};
+
+/*
+		  entry bits
+
+	bits  0-15    move (16 bit)
+	bits 16-31    score (signed)
+	bits 32-39    depth
+	bits 40-41    bound
+	bits 42-47    age
+	bits 48-63    key check (low 16 bits of the key, the cluster index comes from the high bits)
+
+	An entry is a single 64 bit word: a read can't be torn by a concurrent write, so no locks are needed.
+	A different position with the same cluster & key check is taken for a hit (about once in 16k probes
+	of missing positions), a table move is checked by decodeMove before it is played.
+*/
+
+struct TTEntry {
+	std::atomic<uint64_t> m_entry;
+};
+
+// four 8 byte entries, two clusters per 64 byte cache line
+struct alignas(32) TTCluster {
+	TTEntry m_entries[4];
+};
+
+class TranspositionTable {
+
+	TTCluster* m_clusters = nullptr;
+	size_t m_cluster_count = 0;
+
+	// search generation, 6 bits
+	uint8_t m_age = 0;
+
+	TTCluster* cluster(uint64_t key) const;
+
+public:
+
+	TranspositionTable() {}
+
+	explicit TranspositionTable(size_t mb) { resize(mb); }
+
+	~TranspositionTable();
+
+	TranspositionTable(const TranspositionTable&) = delete;
+	TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+	// reallocate to size megabytes (clears the table)
+	void resize(size_t mb);
+
+	void clear();
+
+	// new search: entries of older searches become replaceable
+	void newSearch();
+
+	// lock free lookup, true if key was found
+	bool probe(uint64_t key, TTData& data) const;
+
+	// depth & age aware replacement within the key cluster
+	void store(uint64_t key, int move, int score, int depth, int bound);
+
+	// load the key cluster into the cache ahead of the probe
+	void prefetch(uint64_t key) const;
+
+	// permille of the first entries used by the current search
+	int hashfull() const;
+
+	size_t sizeMb() const { return m_cluster_count * sizeof(TTCluster) / (1024 * 1024); }
+};
+
+// 16 bit move stored in the table
+int compactMove(int move);
+
+void transpositionTableTest();
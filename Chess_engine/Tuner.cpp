@@ -0,0 +1,595 @@
+#include "Tuner.hpp"
+#include "Evaluation.hpp"
+#include "Search.hpp"
+#include "See.hpp"
+#include "Utility.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+//##################################################################################################################
+//                                                     VARIABLES
+//##################################################################################################################
+
+// lines resolved in parallel at once while loading
+const size_t tuner_batch = 1 << 16;
+
+// deepest capture sequence of the quiescence search
+const int tuner_max_ply = 32;
+
+// Adam decay rates of the moments & the term keeping the step finite
+const double adam_beta1 = 0.9;
+const double adam_beta2 = 0.999;
+const double adam_epsilon = 1e-8;
+
+// quiescence search & packing of a thread
+struct TunerWorker {
+	Board board;
+	PawnTable pawn_table;
+	std::vector<uint64_t> move_lists[tuner_max_ply];
+	int pv[tuner_max_ply][tuner_max_ply];
+	int pv_length[tuner_max_ply];
+
+	TunerWorker() {
+		for (std::vector<uint64_t>& move_list : move_lists)
+			move_list.reserve(max_moves);
+	}
+
+	int quiescence(int alpha, int beta, int ply);
+	bool resolve(double result, PackedPosition& position);
+};
+
+//##################################################################################################################
+//                                                     FUNCTIONS
+//##################################################################################################################
+
+// win probability of an eval in centipawns
+static inline double sigmoid(double k, double eval) {
+	return 1.0 / (1.0 + std::pow(10.0, -k * eval / 400.0));
+}
+
+// logistic (cross entropy) loss of a probability against a result
+static inline double logisticLoss(double probability, double result) {
+	probability = std::min(std::max(probability, 1e-12), 1.0 - 1e-12);
+	return -(result * std::log(probability) + (1.0 - result) * std::log(1.0 - probability));
+}
+
+// linear model of a packed position (white point of view)
+static double modelEval(const TunerParameters& parameters, const PackedPosition& position)
+{
+	double mg = 0, eg = 0;
+	uint64_t occupancy = position.occupancy;
+	for (int i = 0; occupancy; i++, occupancy &= occupancy - 1) {
+		int square = get_ls1b_index(occupancy);
+		int piece = (position.pieces[i / 2] >> (4 * (i & 1))) & 15;
+		if (piece < 6) {
+			mg += parameters.mg[piece][square];
+			eg += parameters.eg[piece][square];
+		}
+		else {
+			mg -= parameters.mg[piece - 6][square ^ 56];
+			eg -= parameters.eg[piece - 6][square ^ 56];
+		}
+	}
+	return (mg * position.phase + eg * (max_phase - position.phase)) / max_phase + position.rest;
+}
+
+// the positions split evenly over the threads (the sums don't depend on the scheduling)
+template<typename F>
+static void parallelRanges(size_t count, int threads, F fn)
+{
+	std::vector<std::thread> workers;
+	for (int thread = 1; thread < threads; thread++)
+		workers.emplace_back(fn, count * thread / threads, count * (thread + 1) / threads, thread);
+	fn(0, count / threads, 0);
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+// result for white of a labelled line, false without a label
+static bool parseResult(const std::string& line, size_t from, double& result)
+{
+	if (line.find("1/2-1/2", from) != std::string::npos)
+		result = 0.5;
+	else if (line.find("1-0", from) != std::string::npos)
+		result = 1.0;
+	else if (line.find("0-1", from) != std::string::npos)
+		result = 0.0;
+	else {
+		size_t open = line.find('[', from);
+		if (open == std::string::npos)
+			return false;
+		char* end;
+		result = std::strtod(line.c_str() + open + 1, &end);
+		if (*end != ']' || result < 0.0 || result > 1.0)
+			return false;
+	}
+	return true;
+}
+
+//##################################################################################################################
+//                                                     TUNER WORKER METHODS
+//##################################################################################################################
+
+// captures until the position is quiet, the principal variation leads to the leaf the score comes from.
+// Checks are stood pat like any other position, losing & hopeless captures are pruned as in the search.
+int TunerWorker::quiescence(int alpha, int beta, int ply)
+{
+	pv_length[ply] = ply;
+
+	int stand_pat = evaluate(board, &pawn_table);
+	if (stand_pat >= beta || ply >= tuner_max_ply - 1)
+		return stand_pat;
+	if (stand_pat > alpha)
+		alpha = stand_pat;
+
+	// most valuable victim, least valuable attacker first
+	std::vector<uint64_t>& move_list = move_lists[ply];
+	move_list.clear();
+	board.generateCaptures(&move_list);
+	for (uint64_t& move : move_list) {
+		int victim = get_move_enpassant(move) ? P : board.pieceOn(get_move_target(move));
+		victim = (victim < 0) ? (int)get_move_promoted(move) % 6 : victim % 6;
+		move |= (uint64_t)(victim * 8 + 7 - (int)get_move_piece(move) % 6) << 32;
+	}
+	std::sort(move_list.begin(), move_list.end(), std::greater<uint64_t>());
+
+	for (uint64_t entry : move_list) {
+		int move = (int)(entry & 0xffffffff);
+		int victim = (int)(entry >> 35);
+
+		if (!get_move_promoted(move) && (stand_pat + see_value[victim] + delta_margin <= alpha || !seeGe(board, move, 0)))
+			continue;
+
+		board.copyBoard();
+		if (!board.makeMove(move, only_captures)) {
+			board.clearCopy();
+			continue;
+		}
+		int score = -quiescence(-beta, -alpha, ply + 1);
+		board.takeBack();
+
+		if (score > alpha) {
+			alpha = score;
+			pv[ply][ply] = move;
+			for (int next = ply + 1; next < pv_length[ply + 1]; next++)
+				pv[ply][next] = pv[ply + 1][next];
+			pv_length[ply] = pv_length[ply + 1];
+			if (score >= beta)
+				break;
+		}
+	}
+	return alpha;
+}
+
+// quiet leaf of the board, false in check, for specialised endgames & scaled material
+bool TunerWorker::resolve(double result, PackedPosition& position)
+{
+	if (board.inCheck())
+		return false;
+
+	quiescence(-infinity, infinity, 0);
+	for (int ply = 0; ply < pv_length[0]; ply++) {
+		board.copyBoard();
+		board.makeMove(pv[0][ply], all_moves);
+	}
+
+	// the evaluation is linear in the tables only without endgame evaluators & scale factors
+	MaterialEntry material_scratch;
+	const MaterialEntry& material = probeMaterial(board, material_scratch);
+	if (material.endgame)
+		return false;
+	int eval = evaluate(board, &pawn_table);
+	if (board.side() == black)
+		eval = -eval;
+	int strong = (eval > 0) ? white : black;
+	if (material.scale[strong] && scaleFactor(material.scale[strong], board) != scale_normal)
+		return false;
+
+	int rest = eval - taperedScore(board.scoreMg(), board.scoreEg(), board.phase());
+	if (rest < INT16_MIN || rest > INT16_MAX)
+		return false;
+
+	std::memset(&position, 0, sizeof(position));
+	position.occupancy = board.occupancies()[both];
+	uint64_t occupancy = position.occupancy;
+	for (int i = 0; occupancy; i++, occupancy &= occupancy - 1)
+		position.pieces[i / 2] |= board.pieceOn(get_ls1b_index(occupancy)) << (4 * (i & 1));
+	position.rest = (int16_t)rest;
+	position.phase = std::min((int)board.phase(), max_phase);
+	position.result = (uint8_t)std::lround(result * 2);
+	return true;
+}
+
+//##################################################################################################################
+//                                                     TUNER METHODS
+//##################################################################################################################
+
+Tuner::Tuner(int threads) : m_threads(std::max(threads, 1))
+{
+	for (int piece = P; piece <= K; piece++)
+		for (int square = 0; square < 64; square++) {
+			m_parameters.mg[piece][square] = pst.mg[piece][square];
+			m_parameters.eg[piece][square] = pst.eg[piece][square];
+		}
+}
+
+size_t Tuner::load(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file) {
+		printf("can't open %s\n", path.c_str());
+		return 0;
+	}
+
+	std::vector<TunerWorker> workers(m_threads);
+	std::vector<std::vector<PackedPosition>> resolved(m_threads);
+	std::vector<std::string> lines;
+	lines.reserve(tuner_batch);
+	size_t skipped = 0, read = 0;
+	uint64_t start = get_time_ms();
+
+	while (file) {
+		lines.clear();
+		std::string line;
+		while (lines.size() < tuner_batch && std::getline(file, line))
+			lines.push_back(line);
+		read += lines.size();
+
+		std::vector<size_t> thread_skipped(m_threads, 0);
+		parallelRanges(lines.size(), m_threads, [&](size_t begin, size_t end, int thread) {
+			TunerWorker& worker = workers[thread];
+			PackedPosition position;
+			for (size_t i = begin; i < end; i++) {
+				double result;
+				size_t length;
+				if (worker.board.parseFen(lines[i], &length) != fen_ok || !parseResult(lines[i], length, result)) {
+					thread_skipped[thread]++;
+					continue;
+				}
+				if (worker.resolve(result, position))
+					resolved[thread].push_back(position);
+				else
+					thread_skipped[thread]++;
+			}
+		});
+
+		for (int thread = 0; thread < m_threads; thread++) {
+			m_positions.insert(m_positions.end(), resolved[thread].begin(), resolved[thread].end());
+			resolved[thread].clear();
+			skipped += thread_skipped[thread];
+		}
+	}
+
+	printf("loaded %llu positions of %llu lines (%llu skipped) in %llu ms, %llu bytes each\n", (unsigned long long)m_positions.size(),
+		(unsigned long long)read, (unsigned long long)skipped, (unsigned long long)(get_time_ms() - start), (unsigned long long)sizeof(PackedPosition));
+	return m_positions.size();
+}
+
+bool Tuner::add(const Board& board, double result)
+{
+	static TunerWorker worker;
+	worker.board = board;
+	PackedPosition position;
+	if (!worker.resolve(result, position))
+		return false;
+	m_positions.push_back(position);
+	return true;
+}
+
+double Tuner::loss() const
+{
+	std::vector<double> losses(m_threads, 0.0);
+	parallelRanges(m_positions.size(), m_threads, [&](size_t begin, size_t end, int thread) {
+		double sum = 0;
+		for (size_t i = begin; i < end; i++)
+			sum += logisticLoss(sigmoid(m_k, modelEval(m_parameters, m_positions[i])), m_positions[i].result / 2.0);
+		losses[thread] = sum;
+	});
+
+	double sum = 0;
+	for (double thread_loss : losses)
+		sum += thread_loss;
+	return m_positions.empty() ? 0.0 : sum / m_positions.size();
+}
+
+double Tuner::fitScale()
+{
+	// coarse scan, then finer ones around the best scale
+	double best_k = m_k, best_loss = loss();
+	for (double step = 0.1; step >= 0.001; step /= 10) {
+		double center = best_k;
+		for (int i = -10; i <= 10; i++) {
+			m_k = center + i * step;
+			if (m_k <= 0)
+				continue;
+			double current = loss();
+			if (current < best_loss) {
+				best_loss = current;
+				best_k = m_k;
+			}
+		}
+	}
+	m_k = best_k;
+	return m_k;
+}
+
+void Tuner::gradient(TunerParameters& gradient, double& loss) const
+{
+	std::vector<TunerParameters> gradients(m_threads);
+	std::vector<double> losses(m_threads, 0.0);
+
+	parallelRanges(m_positions.size(), m_threads, [&](size_t begin, size_t end, int thread) {
+		TunerParameters& local = gradients[thread];
+		std::memset(&local, 0, sizeof(local));
+		double sum = 0;
+
+		for (size_t i = begin; i < end; i++) {
+			const PackedPosition& position = m_positions[i];
+			double probability = sigmoid(m_k, modelEval(m_parameters, position));
+			double result = position.result / 2.0;
+			sum += logisticLoss(probability, result);
+
+			// derivative of the loss by the eval, shared out between the midgame & endgame parameters
+			double derivative = (probability - result) * m_k * std::log(10.0) / 400.0;
+			double mg = derivative * position.phase / max_phase;
+			double eg = derivative * (max_phase - position.phase) / max_phase;
+
+			uint64_t occupancy = position.occupancy;
+			for (int j = 0; occupancy; j++, occupancy &= occupancy - 1) {
+				int square = get_ls1b_index(occupancy);
+				int piece = (position.pieces[j / 2] >> (4 * (j & 1))) & 15;
+				if (piece < 6) {
+					local.mg[piece][square] += mg;
+					local.eg[piece][square] += eg;
+				}
+				else {
+					local.mg[piece - 6][square ^ 56] -= mg;
+					local.eg[piece - 6][square ^ 56] -= eg;
+				}
+			}
+		}
+		losses[thread] = sum;
+	});
+
+	// reduce the thread gradients into the mean
+	double scale = m_positions.empty() ? 0.0 : 1.0 / m_positions.size();
+	double* total = &gradient.mg[0][0];
+	for (int i = 0; i < 2 * 6 * 64; i++) {
+		double sum = 0;
+		for (int thread = 0; thread < m_threads; thread++)
+			sum += (&gradients[thread].mg[0][0])[i];
+		total[i] = sum * scale;
+	}
+
+	loss = 0;
+	for (double thread_loss : losses)
+		loss += thread_loss;
+	loss *= scale;
+}
+
+double Tuner::step(double learning_rate)
+{
+	TunerParameters current_gradient;
+	double current_loss;
+	gradient(current_gradient, current_loss);
+
+	// Adam with bias corrected moments
+	m_steps++;
+	double correction1 = 1.0 - std::pow(adam_beta1, m_steps);
+	double correction2 = 1.0 - std::pow(adam_beta2, m_steps);
+	double* parameters = &m_parameters.mg[0][0];
+	double* momentum = &m_momentum.mg[0][0];
+	double* velocity = &m_velocity.mg[0][0];
+	const double* g = &current_gradient.mg[0][0];
+
+	for (int i = 0; i < 2 * 6 * 64; i++) {
+		momentum[i] = adam_beta1 * momentum[i] + (1.0 - adam_beta1) * g[i];
+		velocity[i] = adam_beta2 * velocity[i] + (1.0 - adam_beta2) * g[i] * g[i];
+		parameters[i] -= learning_rate * (momentum[i] / correction1) / (std::sqrt(velocity[i] / correction2) + adam_epsilon);
+	}
+	return current_loss;
+}
+
+bool Tuner::write(const std::string& path) const
+{
+	FILE* file = std::fopen(path.c_str(), "w");
+	if (!file) {
+		printf("can't write %s\n", path.c_str());
+		return false;
+	}
+
+	static const char* piece_names[6] = { "pawn", "knight", "bishop", "rook", "queen", "king" };
+	const double (*tables[2])[64] = { m_parameters.mg, m_parameters.eg };
+	const char* prefixes[2] = { "mg", "eg" };
+
+	// the material value is the mean of the squares a piece can stand on, the tables what is left
+	int values[2][6];
+	for (int phase = 0; phase < 2; phase++)
+		for (int piece = P; piece <= K; piece++) {
+			double sum = 0;
+			int squares = 0;
+			for (int square = 0; square < 64; square++)
+				if (piece != P || (square / 8 != 0 && square / 8 != 7)) {
+					sum += tables[phase][piece][square];
+					squares++;
+				}
+			values[phase][piece] = (piece == K) ? 0 : (int)std::lround(sum / squares);
+		}
+
+	fprintf(file, "// tuned material values [piece type] (k %.3f, %llu positions)\n", m_k, (unsigned long long)m_positions.size());
+	for (int phase = 0; phase < 2; phase++)
+		fprintf(file, "const int %s_value[6] = { %d, %d, %d, %d, %d, %d };\n", prefixes[phase], values[phase][P], values[phase][N],
+			values[phase][B], values[phase][R], values[phase][Q], values[phase][K]);
+
+	for (int phase = 0; phase < 2; phase++) {
+		fprintf(file, "\n// tuned piece square tables [piece type] from white's point of view (a8 first)\n");
+		fprintf(file, "const int %s_table[6][64] = {\n", prefixes[phase]);
+		for (int piece = P; piece <= K; piece++) {
+			fprintf(file, "\t// %s\n\t{\n", piece_names[piece]);
+			for (int row = 0; row < 8; row++) {
+				fprintf(file, "\t\t");
+				for (int file_index = 0; file_index < 8; file_index++) {
+					int square = row * 8 + file_index;
+					int value = (piece == P && (row == 0 || row == 7)) ? 0
+						: (int)std::lround(tables[phase][piece][square]) - values[phase][piece];
+					fprintf(file, "%4d%s", value, (file_index < 7) ? "," : "");
+				}
+				fprintf(file, "%s\n", (row < 7) ? "," : "");
+			}
+			fprintf(file, "\t}%s\n", (piece < K) ? "," : "");
+		}
+		fprintf(file, "};\n");
+	}
+	std::fclose(file);
+	return true;
+}
+
+//##################################################################################################################
+//                                                     TUNE
+//##################################################################################################################
+
+void tune(const std::string& path, int epochs, int threads, const std::string& output)
+{
+	Tuner tuner(threads);
+	if (!tuner.load(path))
+		return;
+
+	printf("k %.3f, loss %.6f\n", tuner.fitScale(), tuner.loss());
+
+	uint64_t start = get_time_ms();
+	for (int epoch = 1; epoch <= epochs; epoch++) {
+		uint64_t epoch_start = get_time_ms();
+		double loss = tuner.step(1.0);
+		if (epoch == 1 || epoch % 10 == 0 || epoch == epochs)
+			printf("epoch %4d  loss %.6f  %llu ms\n", epoch, loss, (unsigned long long)(get_time_ms() - epoch_start));
+		if (epoch % 100 == 0)
+			tuner.write(output);
+	}
+	printf("%d epochs in %llu ms, loss %.6f\n", epochs, (unsigned long long)(get_time_ms() - start), tuner.loss());
+	if (tuner.write(output))
+		printf("tables written to %s\n", output.c_str());
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+void tunerTest(int threads)
+{
+	const int walks = 4000;
+	const int knight_bonus = 40;
+
+	// positions of random games
+	uint64_t start = get_time_ms();
+	Tuner tuner(threads);
+	Board b;
+	std::vector<uint64_t> move_list;
+	srand(2024);
+	for (int walk = 0; walk < walks; walk++) {
+		b.parse_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+		for (int ply = 0; ply < 80; ply++) {
+			move_list.clear();
+			b.generateMoves(&move_list);
+			std::vector<int> legal;
+			for (uint64_t move : move_list) {
+				b.copyBoard();
+				if (b.makeMove((int)move, all_moves)) {
+					legal.push_back((int)move);
+					b.takeBack();
+				}
+				else
+					b.clearCopy();
+			}
+			if (legal.empty())
+				break;
+			b.copyBoard();
+			b.makeMove(legal[random_uint64() % legal.size()], all_moves);
+			if (ply >= 8 && ply % 4 == 0)
+				tuner.add(b, 0.5);
+		}
+	}
+	uint64_t resolve_ms = get_time_ms() - start;
+
+	// the model starts at the evaluation of the leaves
+	Tuner reference(threads);
+	int model_mismatches = 0;
+	for (PackedPosition& position : tuner.positions()) {
+		int mg = 0, eg = 0;
+		uint64_t occupancy = position.occupancy;
+		for (int i = 0; occupancy; i++, occupancy &= occupancy - 1) {
+			int piece = (position.pieces[i / 2] >> (4 * (i & 1))) & 15;
+			mg += pst.mg[piece][get_ls1b_index(occupancy)];
+			eg += pst.eg[piece][get_ls1b_index(occupancy)];
+		}
+		model_mismatches += std::abs(modelEval(reference.parameters(), position) - (taperedScore(mg, eg, position.phase) + position.rest)) > 1.0;
+	}
+
+	// results drawn from the evaluation with the knights worth more
+	TunerParameters truth = reference.parameters();
+	for (int square = 0; square < 64; square++) {
+		truth.mg[N][square] += knight_bonus;
+		truth.eg[N][square] += knight_bonus;
+	}
+	for (PackedPosition& position : tuner.positions()) {
+		double probability = sigmoid(1.0, modelEval(truth, position));
+		double draw = 0.3 * std::min(probability, 1.0 - probability) * 2;
+		double roll = (double)(random_uint64() % 1000000) / 1000000;
+		position.result = (roll < probability - draw / 2) ? 2 : (roll < probability + draw / 2) ? 1 : 0;
+	}
+
+	// analytic gradient against central differences
+	TunerParameters analytic;
+	double loss;
+	tuner.gradient(analytic, loss);
+	double worst_error = 0;
+	const int checks[5][2] = { { P, 36 }, { N, 42 }, { B, 58 }, { Q, 59 }, { K, 62 } };
+	for (auto& check : checks) {
+		for (int phase = 0; phase < 2; phase++) {
+			double& parameter = phase ? tuner.parameters().eg[check[0]][check[1]] : tuner.parameters().mg[check[0]][check[1]];
+			double saved = parameter;
+			parameter = saved + 0.5;
+			double up = tuner.loss();
+			parameter = saved - 0.5;
+			double down = tuner.loss();
+			parameter = saved;
+			double numeric = (up - down) / 1.0;
+			double exact = phase ? analytic.eg[check[0]][check[1]] : analytic.mg[check[0]][check[1]];
+			worst_error = std::max(worst_error, std::abs(numeric - exact) / std::max(std::abs(numeric), 1e-9));
+		}
+	}
+
+	printf("\n     Tuner\n\n");
+	printf("  positions          %llu (%llu bytes each), resolved in %llu ms\n", (unsigned long long)tuner.size(),
+		(unsigned long long)sizeof(PackedPosition), (unsigned long long)resolve_ms);
+	printf("  model mismatches   %d\n", model_mismatches);
+	printf("  gradient error     %.2e (relative, central differences)\n", worst_error);
+	printf("  k                  %.3f\n", tuner.fitScale());
+
+	// the knights should approach the labelling values
+	double first_loss = tuner.loss();
+	uint64_t epoch_ns = 0;
+	const int epochs = 300;
+	for (int epoch = 1; epoch <= epochs; epoch++) {
+		uint64_t epoch_start = get_time_ns();
+		double current = tuner.step(2.0);
+		epoch_ns += get_time_ns() - epoch_start;
+		if (epoch == 1 || epoch % 100 == 0)
+			printf("  epoch %4d         loss %.6f\n", epoch, current);
+	}
+
+	double knight_shift = 0;
+	for (int square = 0; square < 64; square++)
+		knight_shift += (tuner.parameters().mg[N][square] - reference.parameters().mg[N][square]
+			+ tuner.parameters().eg[N][square] - reference.parameters().eg[N][square]) / 128;
+	double epoch_ms = (double)epoch_ns / epochs / 1e6;
+
+	printf("  loss               %.6f -> %.6f\n", first_loss, tuner.loss());
+	printf("  knight shift       %.1f (labelled with +%d)\n", knight_shift, knight_bonus);
+	printf("  epoch              %.3f ms (%.1f M positions/s, %d threads)\n\n", epoch_ms,
+		tuner.size() / epoch_ms / 1000.0, threads);
+}
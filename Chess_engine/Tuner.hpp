@@ -0,0 +1,91 @@
+#pragma once
+#include "Board.hpp"
+#include <string>
+#include <vector>
+
+/*
+		  Texel tuning
+
+	Every labelled position is resolved by a quiescence search, its quiet leaf is packed (occupancy + one
+	nibble per piece) with the game phase & the evaluation terms outside the piece square tables. An
+	epoch evaluates the packed positions as
+
+		eval = (mg . features * phase + eg . features * (max_phase - phase)) / max_phase + rest
+
+	with the material + piece square parameters (mg & eg [piece type][square], black mirrored), & takes
+	one Adam step on the logistic loss of sigmoid(k * eval) against the game result, the gradients summed
+	over all threads.
+*/
+
+// quiet leaf of a labelled position
+struct PackedPosition {
+	uint64_t occupancy;
+	// piece of each occupied square (ascending squares), two per byte
+	uint8_t pieces[16];
+	// evaluation terms outside the tables (white point of view)
+	int16_t rest;
+	uint8_t phase;
+	// game result for white: 0 loss, 1 draw, 2 win
+	uint8_t result;
+};
+
+// material + piece square parameters [piece type][square], white's point of view (a8 first)
+struct TunerParameters {
+	double mg[6][64];
+	double eg[6][64];
+};
+
+class Tuner {
+
+	std::vector<PackedPosition> m_positions;
+	TunerParameters m_parameters;
+
+	// first & second moment estimates of Adam
+	TunerParameters m_momentum = {};
+	TunerParameters m_velocity = {};
+	int m_steps = 0;
+
+	int m_threads = 1;
+
+	// sigmoid scale, eval in centipawns to win probability
+	double m_k = 1.0;
+
+public:
+
+	// starts from the tables of the evaluation
+	explicit Tuner(int threads);
+
+	// labelled positions of an EPD or FEN file ("1-0", "0-1", "1/2-1/2", c9 "..." or [1.0] / [0.5] / [0.0]),
+	// resolved on all threads in batches while reading, returns the number of positions
+	size_t load(const std::string& path);
+
+	// resolve & pack a position with a result for white (1 win, 0.5 draw, 0 loss), false for specialised endgames
+	bool add(const Board& board, double result);
+
+	size_t size() const { return m_positions.size(); }
+	std::vector<PackedPosition>& positions() { return m_positions; }
+
+	// mean logistic loss of the current parameters
+	double loss() const;
+
+	// sigmoid scale minimising the loss of the current parameters
+	double fitScale();
+
+	// one Adam step on the full gradient, returns the loss before the step
+	double step(double learning_rate);
+
+	const TunerParameters& parameters() const { return m_parameters; }
+	TunerParameters& parameters() { return m_parameters; }
+
+	// gradient of the mean loss [piece type][square]
+	void gradient(TunerParameters& gradient, double& loss) const;
+
+	// material values & tables in the layout of Evaluation.cpp
+	bool write(const std::string& path) const;
+};
+
+// tune the evaluation on a labelled file: epochs of Adam steps, tables written to output
+void tune(const std::string& path, int epochs, int threads, const std::string& output);
+
+// gradient against finite differences, loss over the epochs & epoch time on self labelled positions
+void tunerTest(int threads);
@@ -0,0 +1,283 @@
+#include "Uci.hpp"
+#include "Utility.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+//##################################################################################################################
+//                                                     VARIABLES
+//##################################################################################################################
+
+const char* uci_start_position = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+//##################################################################################################################
+//                                                     UCI METHODS
+//##################################################################################################################
+
+Uci::Uci() : m_tt(default_hash_mb), m_smp(&m_tt, 1) {
+	m_board.parse_fen(uci_start_position);
+}
+
+Uci::~Uci() {
+	stopSearch();
+}
+
+void Uci::stopSearch() {
+	m_smp.stop();
+	waitSearch();
+}
+
+void Uci::waitSearch() {
+	if (m_search_thread.joinable())
+		m_search_thread.join();
+}
+
+void Uci::loop(std::istream& input) {
+	// the GUI reads every line as soon as it is written
+	setvbuf(stdout, nullptr, _IONBF, 0);
+
+	std::string line;
+	while (std::getline(input, line))
+		if (!command(line))
+			return;
+	stopSearch();
+}
+
+bool Uci::command(const std::string& line) {
+	std::istringstream input(line);
+	std::string token;
+	input >> token;
+
+	if (token == "uci") {
+		printf("id name Chess_engine\n");
+		printf("id author Chess_engine authors\n");
+		printf("option name Hash type spin default %d min 1 max %d\n", default_hash_mb, max_hash_mb);
+		printf("option name Threads type spin default 1 min 1 max %d\n", max_search_threads);
+		printf("option name Ponder type check default false\n");
+		printf("uciok\n");
+	}
+	else if (token == "isready")
+		printf("readyok\n");
+	else if (token == "setoption")
+		setOption(input);
+	else if (token == "ucinewgame") {
+		stopSearch();
+		m_tt.clear();
+	}
+	else if (token == "position")
+		position(input);
+	else if (token == "go")
+		go(input);
+	else if (token == "stop")
+		stopSearch();
+	else if (token == "ponderhit")
+		m_smp.ponderhit();
+	else if (token == "quit") {
+		stopSearch();
+		return false;
+	}
+	else if (!token.empty())
+		printf("info string unknown command %s\n", token.c_str());
+	return true;
+}
+
+void Uci::setOption(std::istringstream& input) {
+	std::string token, name, value;
+
+	// the name & value may hold spaces
+	input >> token;
+	while (input >> token && token != "value")
+		name += (name.empty() ? "" : " ") + token;
+	while (input >> token)
+		value += (value.empty() ? "" : " ") + token;
+
+	stopSearch();
+	if (name == "Hash") {
+		int mb = std::atoi(value.c_str());
+		m_tt.resize(mb < 1 ? 1 : mb > max_hash_mb ? max_hash_mb : mb);
+	}
+	else if (name == "Threads") {
+		int threads = std::atoi(value.c_str());
+		m_smp.setThreads(threads < 1 ? 1 : threads > max_search_threads ? max_search_threads : threads);
+	}
+	else if (name != "Ponder")
+		printf("info string unknown option %s\n", name.c_str());
+}
+
+void Uci::position(std::istringstream& input) {
+	std::string token, fen;
+	input >> token;
+
+	if (token == "startpos") {
+		fen = uci_start_position;
+		input >> token;
+	}
+	else if (token == "fen") {
+		while (input >> token && token != "moves")
+			fen += token + " ";
+	}
+	else {
+		printf("info string position needs startpos or fen, position set to startpos\n");
+		stopSearch();
+		m_board.parse_fen(uci_start_position);
+		return;
+	}
+
+	stopSearch();
+
+	// the position is built aside & only replaces the board once the FEN & every move are valid, anything else
+	// falls back to the start position so a go never searches a position the GUI didn't send
+	Board board;
+	FenError error = board.parseFen(fen);
+	if (error != fen_ok) {
+		printf("info string invalid fen (%s), position set to startpos\n", fenErrorString(error));
+		m_board.parse_fen(uci_start_position);
+		return;
+	}
+
+	// the moves are played on the board, their keys stay in its history for the repetition detection
+	if (token == "moves") {
+		std::vector<uint64_t> move_list;
+		move_list.reserve(max_moves);
+		while (input >> token) {
+			move_list.clear();
+			board.generateMoves(&move_list);
+
+			bool played = false;
+			for (uint64_t move : move_list) {
+				if (moveToString((int)move) != token)
+					continue;
+				board.copyBoard();
+				played = board.makeMove((int)move, all_moves);
+				if (!played)
+					board.clearCopy();
+				break;
+			}
+			if (!played) {
+				printf("info string illegal move %s, position set to startpos\n", token.c_str());
+				m_board.parse_fen(uci_start_position);
+				return;
+			}
+		}
+	}
+	m_board = board;
+}
+
+void Uci::go(std::istringstream& input) {
+	SearchLimits limits;
+	std::string token;
+	bool limited = false;
+
+	while (input >> token) {
+		if (token == "wtime") input >> limits.time[white];
+		else if (token == "btime") input >> limits.time[black];
+		else if (token == "winc") input >> limits.inc[white];
+		else if (token == "binc") input >> limits.inc[black];
+		else if (token == "movestogo") input >> limits.movestogo;
+		else if (token == "depth") input >> limits.depth;
+		else if (token == "nodes") input >> limits.nodes;
+		else if (token == "movetime") input >> limits.movetime;
+		else if (token == "infinite") limits.infinite = true;
+		else if (token == "ponder") limits.ponder = true;
+		else
+			continue;
+		limited |= token != "infinite" && token != "ponder";
+	}
+
+	// go without a limit searches until stopped
+	if (!limited)
+		limits.infinite = true;
+
+	stopSearch();
+	m_search_done.store(false, std::memory_order_release);
+	m_search_thread = std::thread([this, board = m_board, limits]() {
+		SearchResult result = m_smp.search(board, limits, true);
+		if (!result.best_move)
+			printf("bestmove 0000\n");
+		m_search_done.store(true, std::memory_order_release);
+	});
+
+	// stop & ponderhit only reach a search whose clock has started
+	while (!m_smp.searching() && !m_search_done.load(std::memory_order_acquire))
+		std::this_thread::yield();
+}
+
+//##################################################################################################################
+//                                                     TESTS
+//##################################################################################################################
+
+void uciTest() {
+	Uci uci;
+
+	printf("\n     UCI session\n\n");
+	uci.command("uci");
+	uci.command("setoption name Hash value 16");
+	uci.command("setoption name Threads value 2");
+	uci.command("isready");
+	uci.command("ucinewgame");
+
+	// fixed depth after a few moves
+	uci.command("position startpos moves e2e4 e7e5 g1f3 b8c6");
+	uci.command("go depth 6");
+	uci.waitSearch();
+
+	// nodes & movetime
+	uci.command("position fen r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+	uci.command("go nodes 50000");
+	uci.waitSearch();
+	uint64_t start = get_time_ms();
+	uci.command("go movetime 300");
+	uci.waitSearch();
+	uint64_t movetime_ms = get_time_ms() - start;
+
+	// clocks
+	start = get_time_ms();
+	uci.command("go wtime 10000 btime 10000 winc 100 binc 100");
+	uci.waitSearch();
+	uint64_t clock_ms = get_time_ms() - start;
+
+	// infinite: only stop ends it, the input thread stays responsive meanwhile
+	uci.command("position startpos");
+	uci.command("go infinite");
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	bool searching = uci.searching();
+	uci.command("isready");
+	uint64_t stop_start = get_time_ns();
+	uci.command("stop");
+	double stop_latency_ms = (double)(get_time_ns() - stop_start) / 1e6;
+
+	// ponder: no limit until ponderhit, the clock from then on
+	uci.command("position startpos moves d2d4");
+	uci.command("go ponder wtime 2000 btime 2000");
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	bool pondering = uci.searching();
+	start = get_time_ms();
+	uci.command("ponderhit");
+	uci.waitSearch();
+	uint64_t ponderhit_ms = get_time_ms() - start;
+
+	// mated side to move
+	uci.command("position fen k7/1Q6/1K6/8/8/8/8/8 b - - 0 1");
+	uci.command("go depth 3");
+	uci.waitSearch();
+	// illegal move & invalid FEN: the start position, never a partly played or previous one
+	uci.command("position startpos");
+	uint64_t start_key = uci.board().hashKey();
+	uci.command("position startpos moves e2e4 e7e5");
+	uci.command("position startpos moves e2e4 e7e5 e2e5");
+	bool illegal_reset = uci.board().hashKey() == start_key && uci.board().side() == white;
+	uci.command("position startpos moves d2d4");
+	uci.command("position fen rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e3 0 1");
+	bool invalid_reset = uci.board().hashKey() == start_key && uci.board().side() == white;
+
+	printf("\n  movetime 300       %llu ms\n", (unsigned long long)movetime_ms);
+	printf("  clock 10s + 0.1s   %llu ms\n", (unsigned long long)clock_ms);
+	printf("  infinite           %s after 300 ms\n", searching ? "searching" : "stopped");
+	printf("  stop latency       %.2f ms\n", stop_latency_ms);
+	printf("  ponder             %s after 300 ms, %llu ms after ponderhit\n", pondering ? "searching" : "stopped",
+		(unsigned long long)ponderhit_ms);
+	printf("  illegal move       %s\n", illegal_reset ? "start position" : "WRONG POSITION");
+	printf("  invalid fen        %s\n\n", invalid_reset ? "start position" : "WRONG POSITION");
+	uci.command("quit");
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "Board.hpp"
+#include "LazySmp.hpp"
+#include "TranspositionTable.hpp"
+#include <atomic>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+/*
+		UCI front end
+
+	The input thread parses the commands, the search runs on a thread of its own (with its helper threads),
+	so stop & ponderhit reach it within a poll interval and reading the input never waits on the search.
+	A new search, a new position or an option first stops & joins the running one.
+*/
+
+const int default_hash_mb = 64;
+const int max_hash_mb = 65536;
+const int max_search_threads = 256;
+
+class Uci {
+
+	Board m_board;
+	TranspositionTable m_tt;
+	LazySmp m_smp;
+
+	// thread running m_smp.search(), done once it has printed its bestmove
+	std::thread m_search_thread;
+	std::atomic<bool> m_search_done{ true };
+
+	void position(std::istringstream& input);
+	void go(std::istringstream& input);
+	void setOption(std::istringstream& input);
+
+	// stop the running search & join its thread
+	void stopSearch();
+
+public:
+
+	Uci();
+	~Uci();
+
+	Uci(const Uci&) = delete;
+	Uci& operator=(const Uci&) = delete;
+
+	// handle one command line, false on quit
+	bool command(const std::string& line);
+
+	// read commands until quit or the end of input
+	void loop(std::istream& input);
+
+	// join the running search without stopping it (searches with a limit)
+	void waitSearch();
+
+	bool searching() const { return !m_search_done.load(std::memory_order_acquire); }
+
+	const Board& board() const { return m_board; }
+};
+
+// scripted session: options, positions, every go limit, stop latency & ponderhit
+void uciTest();
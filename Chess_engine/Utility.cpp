@@ -2,6 +2,16 @@
 #include <cstdint>
 #include <iostream>
 #include <chrono>
+#include <immintrin.h>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // set/get/pop bit macros
 #define set_bit(bitboard, square) ((bitboard) |= (1ULL << (square)))
@@ -82,4 +92,77 @@ uint64_t get_time_ms(){
 	auto value = now_ms.time_since_epoch();
 	uint64_t time = value.count();
 	return time;
-}
\ No newline at end of file
+}
+
+// get time in nanoseconds (monotonic, for benchmarks)
+uint64_t get_time_ns(){
+	auto now = std::chrono::steady_clock::now();
+	auto now_ns = std::chrono::time_point_cast<std::chrono::nanoseconds>(now);
+
+	auto value = now_ns.time_since_epoch();
+	uint64_t time = value.count();
+	return time;
+}
+
+//##################################################################################################################
+//                                                     MAPPED FILE METHODS
+//##################################################################################################################
+
+bool MappedFile::open(const std::string& path) {
+	close();
+#ifdef _WIN32
+	m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE) {
+		m_file = nullptr;
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || !size.QuadPart) {
+		close();
+		return false;
+	}
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void* data = m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!data) {
+		close();
+		return false;
+	}
+	m_data = (const uint8_t*)data;
+	m_size = (size_t)size.QuadPart;
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat info;
+	if (fstat(fd, &info) || !info.st_size) {
+		::close(fd);
+		return false;
+	}
+	// the mapping keeps the file alive
+	void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED)
+		return false;
+	m_data = (const uint8_t*)data;
+	m_size = (size_t)info.st_size;
+#endif
+	return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file)
+		CloseHandle(m_file);
+	m_mapping = nullptr;
+	m_file = nullptr;
+#else
+	if (m_data)
+		munmap((void*)m_data, m_size);
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
+#include <string>
 
 uint8_t count_bits(uint64_t bitboard);
 
@@ -11,4 +13,29 @@ uint64_t random_uint64_fewbits();
 
 void printBitboard(uint64_t bitboard);
 
-uint64_t get_time_ms();
\ No newline at end of file
+uint64_t get_time_ms();
+
+uint64_t get_time_ns();
+
+// read only memory mapping of a whole file, pages are loaded by the OS on first access
+class MappedFile {
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#endif
+
+public:
+	MappedFile() {}
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path);
+	void close();
+
+	const uint8_t* data() const { return m_data; }
+	size_t size() const { return m_size; }
+};
@@ -4,6 +4,24 @@
 //#include "Magic_number.hpp"
 #include "Moves.hpp"
 #include "Utility.hpp"
+#include "AllocTracker.hpp"
+#include "Bench.hpp"
+#include "Scaling.hpp"
+#include "Search.hpp"
+#include "LazySmp.hpp"
+#include "MovePicker.hpp"
+#include "See.hpp"
+#include "TimeManager.hpp"
+#include "Evaluation.hpp"
+#include "Pawns.hpp"
+#include "Nnue.hpp"
+#include "AttackMaps.hpp"
+#include "Material.hpp"
+#include "Bitbase.hpp"
+#include "Tablebase.hpp"
+#include "Tuner.hpp"
+#include "Uci.hpp"
+#include "Batch.hpp"
 #include <chrono>
 #include <thread>
 
@@ -15,7 +33,174 @@
 #define cmk_position "r2q1rk1/ppp2ppp/2n1bn2/2b1p3/3pP3/3P1NPP/PPP1NPB1/R1BQ1RK1 b - - 0 9 "
 #define kiwipete_position "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - "
 
-int main(){
+int main(int argc, char* argv[]){
+
+	std::string mode = (argc > 1) ? argv[1] : "";
+
+	// UCI engine on the standard input, the default without a mode; any unknown mode (test) runs the tests below
+	if (mode.empty() || mode == "uci") {
+		Uci uci;
+		uci.loop(std::cin);
+		return 0;
+	}
+
+	// microbenchmark of the core primitives: bench [json path] [repetitions]
+	if (mode == "bench") {
+		return benchTest((argc > 2) ? argv[2] : "bench_results.json", (argc > 3) ? std::atoi(argv[3]) : 0) ? 0 : 1;
+	}
+
+	// iterative deepening search: search [depth] [fen] [hash MB] [movetime ms] [nodes] [tablebase directory]
+	if (mode == "search") {
+		Board board;
+		FenError error = board.parse_fen((argc > 3) ? argv[3] : start_position);
+		if (error != fen_ok) {
+			printf("invalid fen (%s)\n", fenErrorString(error));
+			return 1;
+		}
+		TranspositionTable tt((argc > 4) ? std::atoi(argv[4]) : 64);
+		SearchLimits limits;
+		limits.depth = (argc > 2) ? std::atoi(argv[2]) : 6;
+		limits.movetime = (argc > 5) ? std::atoll(argv[5]) : 0;
+		limits.nodes = (argc > 6) ? std::atoll(argv[6]) : 0;
+		Tablebases tablebases;
+		LazySmp search(&tt, 1);
+		if (argc > 7 && tablebases.load(argv[7]))
+			search.setTablebases(&tablebases);
+		search.search(board, limits);
+		return 0;
+	}
+
+	// endgame tablebase generator: tbgen [materials, KQvK,KRPvKR] [directory] [threads]
+	if (mode == "tbgen") {
+		std::string directory = (argc > 3) ? argv[3] : ".";
+		int threads = (argc > 4) ? std::atoi(argv[4]) : (int)std::thread::hardware_concurrency();
+		Tablebases tablebases;
+		tablebases.load(directory);
+		std::string materials = (argc > 2) ? argv[2] : "KQvK,KRvK,KPvK";
+		for (size_t begin = 0, end; begin < materials.size(); begin = end + 1) {
+			end = materials.find(',', begin);
+			end = (end == std::string::npos) ? materials.size() : end;
+			if (!generateTablebase(materials.substr(begin, end - begin), directory, threads, tablebases))
+				return 1;
+		}
+		return 0;
+	}
+
+	// tablebases generated & checked: tablebases [directory] [threads]
+	if (mode == "tablebases") {
+		tablebaseTest((argc > 2) ? argv[2] : "tablebases", (argc > 3) ? std::atoi(argv[3]) : (int)std::thread::hardware_concurrency());
+		return 0;
+	}
+
+	// FEN parser & writer checks and FENs per second: fen
+	if (mode == "fen") {
+		fenTest();
+		return 0;
+	}
+
+	// texel tuning of the material & piece square tables: tune [labelled epd] [epochs] [threads] [output]
+	if (mode == "tune") {
+		tune((argc > 2) ? argv[2] : "positions.epd", (argc > 3) ? std::atoi(argv[3]) : 1000,
+			(argc > 4) ? std::atoi(argv[4]) : (int)std::thread::hardware_concurrency(), (argc > 5) ? argv[5] : "tuned_tables.txt");
+		return 0;
+	}
+
+	// EPD analysis of every line on all threads: batch [perft|search|eval] [input] [output, - for stdout] [threads] [depth] [nodes] [hash MB]
+	if (mode == "batch") {
+		BatchOptions options;
+		options.mode = (argc > 2) ? argv[2] : "eval";
+		options.threads = (argc > 5) ? std::atoi(argv[5]) : (int)std::thread::hardware_concurrency();
+		options.depth = (argc > 6) ? std::atoi(argv[6]) : (options.mode == "perft") ? 3 : (options.mode == "search") ? 6 : 0;
+		options.nodes = (argc > 7) ? std::atoll(argv[7]) : 0;
+		options.hash_mb = (argc > 8) ? std::atoi(argv[8]) : 16;
+		BatchStats stats;
+		std::string output = (argc > 4) ? argv[4] : "-";
+		if (!runBatch((argc > 3) ? argv[3] : "positions.epd", output, options, stats))
+			return 1;
+		// the statistics stay out of an output on stdout
+		fprintf(output == "-" ? stderr : stdout, "batch: %llu lines, %llu errors, %llu nodes, %llu ms\n", (unsigned long long)stats.lines,
+			(unsigned long long)stats.errors, (unsigned long long)stats.nodes, (unsigned long long)stats.time_ms);
+		return 0;
+	}
+
+	// perft with an optional time limit: perft [depth] [movetime ms] [threads] [fen]
+	if (mode == "perft") {
+		TimeManager time;
+		SearchLimits limits;
+		limits.movetime = (argc > 3) ? std::atoll(argv[3]) : 0;
+		int depth = (argc > 2) ? std::atoi(argv[2]) : 5;
+		int threads = (argc > 4) ? std::atoi(argv[4]) : 1;
+		std::string fen = (argc > 5) ? argv[5] : kiwipete_position;
+		Board board;
+		FenError error = board.parse_fen(fen);
+		if (error != fen_ok) {
+			printf("invalid fen (%s)\n", fenErrorString(error));
+			return 1;
+		}
+
+		time.start(limits, white);
+		if (threads <= 1)
+			return perftTest(fen, depth, &time) ? 0 : 1;
+
+		uint64_t nodes = perftParallel(fen, depth, threads, &time);
+		printf("\n    Nodes: %llu\n     Time: %llu\n%s\n", (unsigned long long)nodes, (unsigned long long)time.elapsedMs(),
+			time.stopped() ? "    (stopped)" : "");
+		return 0;
+	}
+
+	// nodes & time to depth of every pruning technique: pruning [depth]
+	if (mode == "pruning") {
+		pruningTest((argc > 2) ? std::atoi(argv[2]) : 6);
+		return 0;
+	}
+
+	// nnue accumulator check & evaluation throughput: nnue [network file]
+	if (mode == "nnue") {
+		nnueTest((argc > 2) ? argv[2] : "");
+		return 0;
+	}
+
+	// pawn hash table hit rate on the bench positions: pawns [depth]
+	if (mode == "pawns") {
+		pawnHashTest((argc > 2) ? std::atoi(argv[2]) : 6);
+		return 0;
+	}
+
+	// lazy SMP search: smp [depth] [threads] [fen] [hash MB]
+	if (mode == "smp") {
+		Board board;
+		FenError error = board.parse_fen((argc > 4) ? argv[4] : start_position);
+		if (error != fen_ok) {
+			printf("invalid fen (%s)\n", fenErrorString(error));
+			return 1;
+		}
+		TranspositionTable tt((argc > 5) ? std::atoi(argv[5]) : 64);
+		LazySmp smp(&tt, (argc > 3) ? std::atoi(argv[3]) : (int)std::thread::hardware_concurrency());
+		smp.search(board, (argc > 2) ? std::atoi(argv[2]) : 7);
+		return 0;
+	}
+
+	// lazy SMP time to depth at 1, 2, 4, ... threads: smpscaling [depth] [max threads] [json path]
+	if (mode == "smpscaling") {
+		smpScalingTest(kiwipete_position, (argc > 2) ? std::atoi(argv[2]) : 5, (argc > 3) ? std::atoi(argv[3]) : 64,
+			(argc > 4) ? argv[4] : "smp_scaling_results.json");
+		return 0;
+	}
+
+	// batch analysis at 1, 2, 4, ... threads: scaling batch [epd] [perft|search|eval] [depth] [max threads] [json path]
+	if (mode == "scaling" && argc > 2 && std::string(argv[2]) == "batch") {
+		std::string batch_mode = (argc > 4) ? argv[4] : "perft";
+		batchScalingTest((argc > 3) ? argv[3] : "positions.epd", batch_mode, (argc > 5) ? std::atoi(argv[5]) : (batch_mode == "search") ? 6 : 3,
+			(argc > 6) ? std::atoi(argv[6]) : 0, (argc > 7) ? argv[7] : "batch_scaling_results.json");
+		return 0;
+	}
+
+	// parallel perft at 1, 2, 4, ... threads: scaling [depth] [max threads] [json path]
+	if (mode == "scaling") {
+		scalingTest(kiwipete_position, (argc > 2) ? std::atoi(argv[2]) : 5, (argc > 3) ? std::atoi(argv[3]) : 0,
+			(argc > 4) ? argv[4] : "scaling_results.json");
+		return 0;
+	}
 
 	/*Board b;
 	b.add_piece(0, 3, 6);
@@ -37,7 +222,11 @@ int main(){
 
 	//moveTest();
 
+	//allocTrackerTest();
+
 	//boardTest();
+
+	//fenTest();
 	
 	//isAttackedTest();
 
@@ -46,8 +235,43 @@ int main(){
 	//copyTakeBackTest();
 
 	//makeMoveTest();
+
+	//searchTest();
+
+	//transpositionTableTest();
+
+	//captureGenerationTest();
+
+	//repetitionTest();
+
+	//stagedGenerationTest();
+
+	//movePickerTest();
+
+	//seeTest();
+
+	//timeManagerTest();
+
+	//evaluationTest();
+
+	//pawnHashTest(6);
+
+	//attackMapsTest();
+
+	//materialTest();
+
+	//kpkTest();
+
+	//tablebaseTest("tablebases", 4);
+
+	//tunerTest(4);
+
+	//uciTest();
+
+	//batchTest(4);
 	
-	perftTest(start_position, 4);
+	if (!perftTest(start_position, 4))
+		return 1;
 
 	//perftTest(kiwipete_position, 5);
 